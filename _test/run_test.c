@@ -72,6 +72,47 @@ struct run_test_t test_fun_array[] = {
 	{ test_sched_20 },
 	{ test_sched_21 },
 	{ test_sched_22 },
+
+	/* tests extended scheduler API - see test_api.c */
+	{ test_sched_23 },
+	{ test_sched_24 },
+	{ test_sched_25 },
+	{ test_sched_26 },
+	{ test_sched_27 },
+	{ test_sched_28 },
+
+	/* tests synchronization between tasks - see test_sync.c */
+	{ test_sched_29 },
+	{ test_sched_30 },
+	{ test_sched_31 },
+	{ test_sched_32 },
+	{ test_sched_33 },
+	{ test_sched_34 },
+	{ test_sched_35 },
+	{ test_sched_36 },
+	{ test_sched_37 },
+	{ test_sched_38 },
+	{ test_sched_39 },
+	{ test_sched_40 },
+	{ test_sched_41 },
+	{ test_sched_42 },
+	{ test_sched_43 },
+	{ test_sched_44 },
+	{ test_sched_45 },
+	{ test_sched_46 },
+	{ test_sched_47 },
+	{ test_sched_48 },
+	{ test_sched_49 },
+	{ test_sched_50 },
+	{ test_sched_51 },
+	{ test_sched_52 },
+	{ test_sched_53 },
+	{ test_sched_54 },
+	{ test_sched_55 },
+	{ test_sched_56 },
+	{ test_sched_57 },
+	{ test_sched_58 },
+	{ test_sched_59 },
 };
 
 /* custom main testing thread */
@@ -32,11 +32,73 @@ typedef DWORD tid_t;
  * the maximum priority that can be assigned to a thread
  */
 #define SO_MAX_PRIO 5
+
+/*
+ * the maximum number of read-write locks a task may hold for reading
+ */
+#define SO_MAX_READ_LOCKS 8
+
 /*
  * the maximum number of events
  */
 #define SO_MAX_NUM_EVENTS 256
 
+/*
+ * flag for tasks that are run on the context of the task dispatching them,
+ * if that task has terminated, instead of getting their own thread
+ */
+#define SO_TASK_INLINE 1
+
+/*
+ * flag for tasks whose handler runs in a separate process, so a crash of
+ * the handler does not bring down the scheduler. The handler may only call
+ * so_exec, so_yield, so_wait and so_signal.
+ */
+#define SO_TASK_PROCESS 2
+
+/*
+ * flag for task graphs whose priorities are given by the length of the
+ * longest path from each task to the end of the graph
+ */
+#define SO_TASK_DAG_CRITICAL_PATH 1
+
+/*
+ * actions taken when a task has spent its budget: lower its priority to
+ * SO_MIN_PRIORITY, cancel it or only mark it, see so_budget_exceeded
+ */
+#define SO_BUDGET_DEMOTE 0
+#define SO_BUDGET_CANCEL 1
+#define SO_BUDGET_REPORT 2
+
+/*
+ * the default and the maximum weight of a task group
+ */
+#define SO_GROUP_DEFAULT_WEIGHT 100
+#define SO_GROUP_MAX_WEIGHT 10000
+
+/*
+ * the maximum number of tasks moved by a call of so_sched_balance
+ */
+#define SO_BALANCE_MAX_MOVES 4
+
+/*
+ * ready tasks per scheduler above which so_sched_autoscale adds one and
+ * below which it removes one
+ */
+#define SO_SCALE_UP_READY 4
+#define SO_SCALE_DOWN_READY 1
+
+/*
+ * limits of the wake affine placement, see so_sched_set_wake_affine
+ */
+#define SO_WAKE_AFFINE_QUEUE 4
+#define SO_WAKE_AFFINE_MAX 2
+
+/*
+ * number of switches after which the adaptive quantum is adjusted
+ */
+#define SO_ADAPT_WINDOW 64
+
 /*
  * return value of failed tasks
  */
@@ -50,6 +112,107 @@ extern "C" {
  * handler prototype
  */
 typedef void (so_handler)(unsigned int);
+typedef void (so_arg_handler)(void *);
+typedef void *(so_future_handler)(void *);
+typedef void (so_range_handler)(unsigned long, unsigned long, void *);
+
+/*
+ * future of a task, used to take its result
+ */
+typedef tid_t so_future_t;
+
+/*
+ * group of tasks, private to the scheduler
+ */
+typedef struct task_group so_task_group_t;
+
+/*
+ * attributes of a new task, cpu_mask has a bit set for each cpu whose
+ * scheduler the task may be moved to, 0 for any scheduler
+ */
+typedef struct {
+	unsigned int priority;
+	unsigned int flags;
+	unsigned long budget;
+	unsigned int budget_action;
+	so_task_group_t *group;
+	unsigned long cpu_mask;
+} so_task_attr_t;
+
+/*
+ * mutex shared by tasks, the fields are private to the scheduler
+ */
+typedef struct {
+	void *owner;
+	void *waiters;
+	void *next_owned;
+	void *sched;
+} so_task_mutex_t;
+
+/*
+ * synchronization objects shared by tasks, the fields are private to the
+ * scheduler
+ */
+typedef struct {
+	unsigned int value;
+	void *waiters;
+	void *sched;
+} so_task_sem_t;
+
+typedef struct {
+	unsigned int count;
+	unsigned int arrived;
+	void *waiters;
+	void *sched;
+} so_task_barrier_t;
+
+typedef struct {
+	unsigned int readers;
+	void *writer;
+	void *waiting_readers;
+	void *waiting_writers;
+	void *next_written;
+	void *sched;
+} so_task_rwlock_t;
+
+typedef struct {
+	char *buffer;
+	size_t elem_size;
+	unsigned int capacity;
+	unsigned int head;
+	unsigned int count;
+	void *senders;
+	void *receivers;
+	void *sched;
+} so_task_chan_t;
+
+/*
+ * task of a task graph
+ */
+typedef struct {
+	so_arg_handler *handler;
+	void *arg;
+	unsigned int priority;
+} so_task_dag_node_t;
+
+/*
+ * dependency of a task graph: to runs after from has terminated
+ */
+typedef struct {
+	unsigned int from;
+	unsigned int to;
+} so_task_dag_edge_t;
+
+/*
+ * returned by so_task_barrier_wait to the last task reaching the barrier
+ */
+#define SO_BARRIER_SERIAL 1
+#define SO_JOIN_CANCELLED 1
+
+/*
+ * scheduler instance, private to the library
+ */
+typedef struct so_scheduler so_sched_t;
 
 /*
  * creates and initializes scheduler
@@ -59,6 +222,18 @@ typedef void (so_handler)(unsigned int);
  */
 DECL_PREFIX int so_init(unsigned int time_quantum, unsigned int io);
 
+/*
+ * creates and initializes scheduler with a time quantum for each priority,
+ * e.g. longer ones for the batch tasks with a low priority, to switch less
+ * often, and shorter ones for the interactive tasks with a high priority,
+ * to answer faster
+ * + time quantum for each priority, SO_MAX_PRIORITY + 1 values
+ * + number of IO devices supported
+ * returns: 0 on success or negative on error
+ */
+DECL_PREFIX int so_init_quanta(const unsigned int *time_quanta,
+		unsigned int io);
+
 /*
  * creates a new so_task_t and runs it according to the scheduler
  * + handler function
@@ -67,6 +242,42 @@ DECL_PREFIX int so_init(unsigned int time_quantum, unsigned int io);
  */
 DECL_PREFIX tid_t so_fork(so_handler *func, unsigned int priority);
 
+/*
+ * creates a new so_task_t which receives an argument
+ * + handler function
+ * + argument given to the handler
+ * + priority
+ * returns: tid of the new task if successful or INVALID_TID
+ */
+DECL_PREFIX tid_t so_fork_arg(so_arg_handler *func, void *arg,
+			unsigned int priority);
+
+/*
+ * creates a new so_task_t whose result can be taken with so_future_get
+ * + handler function returning the result
+ * + argument given to the handler
+ * + priority
+ * returns: future of the new task if successful or INVALID_TID
+ */
+DECL_PREFIX so_future_t so_fork_future(so_future_handler *func, void *arg,
+			unsigned int priority);
+
+/*
+ * initializes the attributes of a task with the default values
+ * + attributes
+ */
+DECL_PREFIX void so_task_attr_init(so_task_attr_t *attr);
+
+/*
+ * creates a new so_task_t with the given attributes
+ * + handler function
+ * + argument given to the handler
+ * + attributes (priority, flags)
+ * returns: tid of the new task if successful or INVALID_TID
+ */
+DECL_PREFIX tid_t so_fork_attr(so_arg_handler *func, void *arg,
+			const so_task_attr_t *attr);
+
 /*
  * waits for an IO device
  * + device index
@@ -86,6 +297,466 @@ DECL_PREFIX int so_signal(unsigned int io);
  */
 DECL_PREFIX void so_exec(void);
 
+/*
+ * gives up the rest of the quantum to a task with the same priority
+ */
+DECL_PREFIX void so_yield(void);
+
+/*
+ * changes the priority of a task
+ * + tid of the task
+ * + new priority
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_set_priority(tid_t tid, unsigned int priority);
+
+/*
+ * cancels a task. A task which is not running is removed from the queue it
+ * waits in and terminated right away, the running task leaves its handler
+ * at the next scheduling point. The task mutexes and read-write locks it
+ * holds are released. Task semaphore permits have no owner, so the ones it
+ * took are not given back, except for a permit handed to it by a post
+ * while it was waiting and before it ran again. A task cancelled while
+ * waiting at a barrier no longer counts as arrived.
+ * + tid of the task
+ * returns: -1 if the task does not exist or has terminated or 0 on success
+ */
+DECL_PREFIX int so_kill(tid_t tid);
+
+/*
+ * checks if a task has spent the budget given at fork
+ * + tid of the task
+ * returns: 1 if it has, 0 if it has not or -1 if the task does not exist
+ */
+DECL_PREFIX int so_budget_exceeded(tid_t tid);
+
+/*
+ * gets the tid of the calling task
+ * returns: the tid or INVALID_TID if the caller is not a task
+ */
+DECL_PREFIX tid_t so_self(void);
+
+/*
+ * waits for a task to terminate
+ * + tid of the task
+ * returns: -1 if the task does not exist, SO_JOIN_CANCELLED if it was
+ * cancelled or 0 if it ended by itself
+ */
+DECL_PREFIX int so_join(tid_t tid);
+
+/*
+ * waits for a group of tasks to terminate
+ * + tids of the tasks
+ * + number of tasks
+ * returns: -1 if the tids are missing or any of the tasks does not exist,
+ * SO_JOIN_CANCELLED if any of them was cancelled or 0 on success
+ */
+DECL_PREFIX int so_wait_all(const tid_t *tids, unsigned int count);
+
+/*
+ * waits for the task of a future to terminate and takes its result
+ * + future
+ * + where the result is stored
+ * returns: -1 if the future does not exist or was cancelled or 0 on
+ * success
+ */
+DECL_PREFIX int so_future_get(so_future_t future, void **result);
+
+/*
+ * initializes a mutex shared by tasks
+ * + mutex
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_task_mutex_init(so_task_mutex_t *mutex);
+
+/*
+ * locks a mutex, waiting for it if it is held by another task. The owner
+ * inherits the priority of the tasks waiting for the mutex, those of other
+ * groups included. The priority orders only the tasks of a group, so the
+ * owner gets ahead of the other tasks of its group, but its group still
+ * waits for its turn by its weight.
+ * + mutex
+ * returns: 0 on success or -1 if the mutex is already held by the caller
+ * or is not valid
+ */
+DECL_PREFIX int so_task_mutex_lock(so_task_mutex_t *mutex);
+
+/*
+ * unlocks a mutex and hands it to the waiting task with the highest
+ * priority
+ * + mutex
+ * returns: 0 on success or -1 if the mutex is not held by the caller or is
+ * not valid
+ */
+DECL_PREFIX int so_task_mutex_unlock(so_task_mutex_t *mutex);
+
+/*
+ * destroys a mutex shared by tasks
+ * + mutex
+ */
+DECL_PREFIX void so_task_mutex_destroy(so_task_mutex_t *mutex);
+
+/*
+ * initializes a counting semaphore shared by tasks
+ * + semaphore
+ * + initial number of permits
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_task_sem_init(so_task_sem_t *sem, unsigned int value);
+
+/*
+ * takes a permit, waiting for one if there is none available
+ * + semaphore
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_task_sem_wait(so_task_sem_t *sem);
+
+/*
+ * releases a permit, handing it to the waiting task with the highest
+ * priority
+ * + semaphore
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_task_sem_post(so_task_sem_t *sem);
+
+/*
+ * destroys a counting semaphore shared by tasks
+ * + semaphore
+ */
+DECL_PREFIX void so_task_sem_destroy(so_task_sem_t *sem);
+
+/*
+ * initializes a barrier shared by tasks
+ * + barrier
+ * + number of tasks that need to reach the barrier
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_task_barrier_init(so_task_barrier_t *barrier,
+			unsigned int count);
+
+/*
+ * waits until all the tasks reach the barrier
+ * + barrier
+ * returns: SO_BARRIER_SERIAL for the last task reaching the barrier,
+ * 0 for the others or -1 on error
+ */
+DECL_PREFIX int so_task_barrier_wait(so_task_barrier_t *barrier);
+
+/*
+ * destroys a barrier shared by tasks
+ * + barrier
+ */
+DECL_PREFIX void so_task_barrier_destroy(so_task_barrier_t *barrier);
+
+/*
+ * initializes a read-write lock shared by tasks
+ * + lock
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_task_rwlock_init(so_task_rwlock_t *rwlock);
+
+/*
+ * locks for reading, waiting while a task writes or while a task with a
+ * higher priority waits to write
+ * + lock
+ * returns: 0 on success or -1 on error or if the caller already holds
+ * SO_MAX_READ_LOCKS locks for reading
+ */
+DECL_PREFIX int so_task_rwlock_rdlock(so_task_rwlock_t *rwlock);
+
+/*
+ * locks for writing, waiting while other tasks hold the lock
+ * + lock
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_task_rwlock_wrlock(so_task_rwlock_t *rwlock);
+
+/*
+ * unlocks a read-write lock held by the caller, for writing or reading
+ * + lock
+ * returns: 0 on success or -1 if the lock is not held by the caller
+ */
+DECL_PREFIX int so_task_rwlock_unlock(so_task_rwlock_t *rwlock);
+
+/*
+ * destroys a read-write lock shared by tasks
+ * + lock
+ */
+DECL_PREFIX void so_task_rwlock_destroy(so_task_rwlock_t *rwlock);
+
+/*
+ * initializes a bounded channel shared by tasks
+ * + channel
+ * + size of an element
+ * + maximum number of buffered elements
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_task_chan_init(so_task_chan_t *chan, size_t elem_size,
+			unsigned int capacity);
+
+/*
+ * sends an element, waiting while the channel is full
+ * + channel
+ * + element
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_task_chan_send(so_task_chan_t *chan, const void *elem);
+
+/*
+ * receives the oldest element, waiting while the channel is empty
+ * + channel
+ * + buffer for the element
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_task_chan_recv(so_task_chan_t *chan, void *elem);
+
+/*
+ * sends a group of elements in order, waiting while the channel is full
+ * + channel
+ * + elements
+ * + number of elements
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_task_chan_send_many(so_task_chan_t *chan,
+			const void *elems, unsigned int count);
+
+/*
+ * receives up to count elements, waiting only while the channel is empty
+ * + channel
+ * + buffer for the elements
+ * + maximum number of elements
+ * returns: number of elements received or -1 on error
+ */
+DECL_PREFIX int so_task_chan_recv_many(so_task_chan_t *chan, void *elems,
+			unsigned int count);
+
+/*
+ * destroys a bounded channel shared by tasks
+ * + channel
+ */
+DECL_PREFIX void so_task_chan_destroy(so_task_chan_t *chan);
+
+/*
+ * runs a graph of tasks and waits for all of them to terminate. A task is
+ * forked only after all the tasks it depends on have ended by themselves:
+ * the tasks depending on a cancelled task are skipped.
+ * + tasks
+ * + number of tasks
+ * + dependencies
+ * + number of dependencies
+ * + SO_TASK_DAG_* flags
+ * returns: 0 on success or -1 if the graph is not valid or has cycles or
+ * a task was cancelled
+ */
+DECL_PREFIX int so_task_dag_run(const so_task_dag_node_t *nodes,
+			unsigned int num_nodes, const so_task_dag_edge_t *edges,
+			unsigned int num_edges, unsigned int flags);
+
+/*
+ * runs a handler over the chunks of a range of indexes and waits for all
+ * of them to finish. The chunks are taken one by one by a few worker
+ * tasks, not by a task for each chunk.
+ * + first index of the range
+ * + index after the last one
+ * + maximum number of indexes in a chunk
+ * + handler called with the first and after-last index of each chunk
+ * + argument given to the handler
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_parallel_for(unsigned long begin, unsigned long end,
+			unsigned long grain, so_range_handler *func, void *arg);
+
+/*
+ * creates a group of tasks, which gets a share of the time of its parent
+ * proportional to its weight
+ * + parent group or NULL for the root group
+ * + weight, from 1 to SO_GROUP_MAX_WEIGHT
+ * returns: the new group or NULL on error
+ */
+DECL_PREFIX so_task_group_t *so_task_group_create(so_task_group_t *parent,
+			unsigned int weight);
+
+/*
+ * limits the time units a group and its subgroups may run in each period
+ * + group
+ * + number of units in a period, 0 for no limit
+ * + length of a period in units
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_task_group_set_quota(so_task_group_t *group,
+			unsigned long quota, unsigned long period);
+
+/*
+ * makes a group a gang: once it is chosen, each of its ready tasks runs a
+ * quantum, one after another, before another group is chosen, so tasks
+ * working together make progress together
+ * + group
+ * + 1 to make the group a gang, 0 to make it a regular group
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_task_group_set_gang(so_task_group_t *group, int gang);
+
+/*
+ * destroys a group with no subgroups and no tasks left
+ * + group
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_task_group_destroy(so_task_group_t *group);
+
+/*
+ * creates and initializes a scheduler independent of the default one, with
+ * its own tasks and lock. A task mutex, semaphore, barrier, read-write lock
+ * or channel belongs to the scheduler of the first task using it: the
+ * calls of the tasks of other schedulers on it fail.
+ * + time quantum for each thread
+ * + number of IO devices supported
+ * returns: the scheduler or NULL on error
+ */
+DECL_PREFIX so_sched_t *so_sched_create(unsigned int time_quantum,
+			unsigned int io);
+
+/*
+ * makes the calling thread use a scheduler for the calls of the API. The
+ * tasks of a scheduler always use it: called by a task with another
+ * scheduler, it changes nothing and fails.
+ * + scheduler or NULL for the default one, initialized by so_init
+ * returns: the scheduler used before or NULL if the caller is a task of
+ * another scheduler
+ */
+DECL_PREFIX so_sched_t *so_sched_use(so_sched_t *sched);
+
+/*
+ * waits for the tasks of a scheduler created by so_sched_create and
+ * destroys it
+ * + scheduler
+ */
+DECL_PREFIX void so_sched_destroy(so_sched_t *sched);
+
+/*
+ * changes the time quantum of a priority. The tasks with that priority get
+ * it starting with their next quantum.
+ * + priority
+ * + time quantum
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_sched_set_quantum(unsigned int priority,
+		unsigned int time_quantum);
+
+/*
+ * makes the quantum adaptive: the time the tasks spend switching is
+ * measured and, every SO_ADAPT_WINDOW switches, the quantum is doubled
+ * while the switches take more than the target part of the time and halved
+ * while they take less than half of it. While it is adaptive, all the
+ * priorities get the same quantum, starting with the lower bound.
+ * + lower bound of the quantum
+ * + upper bound of the quantum
+ * + target switch overhead in percent, less than 100, or 0 to go back to
+ * the quantum of each priority
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_sched_set_adaptive(unsigned int min_quantum,
+		unsigned int max_quantum, unsigned int target);
+
+/*
+ * gets the quantum a priority gets now
+ * + priority
+ * returns: the quantum or 0 on error
+ */
+DECL_PREFIX unsigned int so_sched_get_quantum(unsigned int priority);
+
+/*
+ * makes a task preempted by a task with a higher priority keep the rest of
+ * its quantum and go back at the head of its priority, instead of getting
+ * a new quantum at the end of it, so the tasks with a lower priority
+ * advance at the same pace under bursts of tasks with a higher priority
+ * + 1 to keep the quantum, 0 to start a new one
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_sched_set_carry_over(int enable);
+
+/*
+ * places the tasks woken by so_signal in front of the ready tasks with
+ * their priority, instead of at the end, so they run right after the
+ * signalling task while its data is still in the cache. It is done only
+ * while their group has less than SO_WAKE_AFFINE_QUEUE ready tasks and for
+ * the first SO_WAKE_AFFINE_MAX tasks woken by a signal.
+ * + 1 to enable the placement, 0 to disable it
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_sched_set_wake_affine(int enable);
+
+/*
+ * pins the threads the scheduler creates from now on to a cpu. Only one task
+ * runs at a time, so keeping them on one cpu saves the cost of waking a
+ * thread on another cpu and moving its data there at every switch.
+ * A task whose thread cannot be pinned, because the cpu is outside the
+ * affinity mask of the process, is not forked. An inline task, which
+ * gets its thread later, runs on any cpu instead.
+ * + cpu or -1 to let the threads run on any cpu
+ * returns: 0 on success or -1 if the cpu index is not valid
+ */
+DECL_PREFIX int so_sched_set_cpu(int cpu);
+
+/*
+ * moves a ready task of the scheduler of the caller to another scheduler,
+ * at the end of its priority. Tasks joined by others, holding task
+ * mutexes or read-write locks or woken up with a semaphore permit they
+ * have not taken yet stay where they are, as do the tasks whose thread
+ * cannot be pinned to the cpu of the other scheduler. A moved task can no
+ * longer use the synchronization objects of its old scheduler.
+ * + tid of the task
+ * + scheduler the task is moved to
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_sched_migrate(tid_t tid, so_sched_t *to);
+
+/*
+ * moves all the ready tasks that can be moved, as so_sched_migrate does,
+ * to another scheduler, before this one is destroyed or left idle
+ * + scheduler the tasks are moved to
+ * returns: the number of tasks moved or -1 on error
+ */
+DECL_PREFIX int so_sched_drain(so_sched_t *to);
+
+/*
+ * gets the number of ready tasks of a scheduler, from which the number of
+ * schedulers may be adjusted
+ * + scheduler or NULL for the one of the caller
+ * returns: the number of ready tasks or -1 on error
+ */
+DECL_PREFIX int so_sched_ready_tasks(so_sched_t *sched);
+
+/*
+ * moves ready tasks from the most loaded scheduler of a set to the least
+ * loaded one, to be called periodically. The load of a scheduler is the
+ * sum of the priorities of its ready tasks, plus one for each. The tasks
+ * which have not run for the longest time are moved first, at most
+ * SO_BALANCE_MAX_MOVES at a call, and only while the receiving scheduler
+ * stays less loaded.
+ * + schedulers
+ * + number of schedulers
+ * returns: the number of tasks moved or -1 on error
+ */
+DECL_PREFIX int so_sched_balance(so_sched_t **scheds, unsigned int count);
+
+/*
+ * adjusts the number of schedulers of a set to its ready tasks, to be
+ * called periodically, like so_sched_balance. While there are more than
+ * SO_SCALE_UP_READY ready tasks for each scheduler, a new one, with the
+ * quanta and devices of the first, is added at the end of the set and
+ * balanced with the others. It is not pinned to a cpu. While the others
+ * would have less than SO_SCALE_DOWN_READY each, the last one is drained
+ * into the least loaded of them and destroyed, once it has no task left
+ * and unless it is the default scheduler or the one of the caller.
+ * At most one scheduler is added or removed at a call.
+ * + schedulers, with room for max of them
+ * + number of schedulers, updated
+ * + maximum number of schedulers
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_sched_autoscale(so_sched_t **scheds, unsigned int *count,
+		unsigned int max);
+
 /*
  * destroys a scheduler
  */
@@ -0,0 +1,1874 @@
+/*
+ * Threads scheduler extended API tests
+ *
+ * 2017, Operating Systems
+ */
+
+#define _GNU_SOURCE
+#include "scheduler_test.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static unsigned int test_exec_status;
+static tid_t test_exec_last_tid;
+
+#define SO_TEST_AND_SET(expect_id, new_id) \
+	do { \
+		if (equal_tids((expect_id), INVALID_TID) || \
+				equal_tids((new_id), INVALID_TID)) \
+			so_fail("invalid task id"); \
+		if (!equal_tids(test_exec_last_tid, (expect_id))) \
+			so_fail("invalid tasks order"); \
+		test_exec_last_tid = (new_id); \
+	} while (0)
+
+/*
+ * 23) Test yield
+ *
+ * tests if a task can hand the processor to a peer with the same priority
+ */
+static tid_t test_tid_23_1;
+static tid_t test_tid_23_2;
+
+static void test_sched_handler_23_2(unsigned int dummy)
+{
+	SO_TEST_AND_SET(test_tid_23_1, test_tid_23_2);
+	so_yield();
+	SO_TEST_AND_SET(test_tid_23_1, test_tid_23_2);
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+static void test_sched_handler_23_1(unsigned int dummy)
+{
+	test_exec_last_tid = test_tid_23_1 = get_tid();
+
+	/* alone on the processor - yield should not switch */
+	so_yield();
+	SO_TEST_AND_SET(test_tid_23_1, test_tid_23_1);
+
+	test_tid_23_2 = so_fork(test_sched_handler_23_2, 0);
+
+	/* the quantum is large, so I should still be running */
+	SO_TEST_AND_SET(test_tid_23_1, test_tid_23_1);
+	so_yield();
+	SO_TEST_AND_SET(test_tid_23_2, test_tid_23_1);
+}
+
+void test_sched_23(void)
+{
+	test_exec_status = SO_TEST_FAIL;
+
+	so_init(SO_MAX_UNITS, 0);
+
+	so_fork(test_sched_handler_23_1, 0);
+
+	sched_yield();
+	so_end();
+
+	basic_test(test_exec_status);
+}
+
+
+/*
+ * 24) Test set priority
+ *
+ * tests if the priority of a ready, running and waiting task can be changed
+ */
+static tid_t test_tid_24_1;
+static tid_t test_tid_24_2;
+static tid_t test_tid_24_3;
+
+static void test_sched_handler_24_3(unsigned int dummy)
+{
+	/* I preempt the forking task before so_fork returns */
+	test_tid_24_3 = get_tid();
+	SO_TEST_AND_SET(test_tid_24_1, test_tid_24_3);
+	so_wait(0);
+
+	/* lowered while waiting - scheduled after the other P0 task */
+	SO_TEST_AND_SET(test_tid_24_2, test_tid_24_3);
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+static void test_sched_handler_24_2(unsigned int dummy)
+{
+	/* boosted above the task which forked me */
+	SO_TEST_AND_SET(test_tid_24_1, test_tid_24_2);
+
+	/* lower my own priority - I should be preempted */
+	if (so_set_priority(get_tid(), 0) < 0)
+		so_fail("cannot lower own priority");
+	SO_TEST_AND_SET(test_tid_24_1, test_tid_24_2);
+}
+
+static void test_sched_handler_24_1(unsigned int dummy)
+{
+	test_exec_last_tid = test_tid_24_1 = get_tid();
+
+	if (so_set_priority(INVALID_TID, 0) == 0)
+		so_fail("invalid task id accepted");
+	if (so_set_priority(test_tid_24_1, SO_MAX_PRIO + 1) == 0)
+		so_fail("invalid priority accepted");
+
+	test_tid_24_2 = so_fork(test_sched_handler_24_2, 0);
+	SO_TEST_AND_SET(test_tid_24_1, test_tid_24_1);
+
+	if (so_set_priority(test_tid_24_2, 2) < 0)
+		so_fail("cannot boost a ready task");
+	SO_TEST_AND_SET(test_tid_24_2, test_tid_24_1);
+
+	test_tid_24_3 = so_fork(test_sched_handler_24_3, 2);
+	SO_TEST_AND_SET(test_tid_24_3, test_tid_24_1);
+
+	if (so_set_priority(test_tid_24_3, 0) < 0)
+		so_fail("cannot change the priority of a waiting task");
+	so_signal(0);
+	SO_TEST_AND_SET(test_tid_24_1, test_tid_24_1);
+}
+
+void test_sched_24(void)
+{
+	test_exec_status = SO_TEST_FAIL;
+
+	so_init(SO_MAX_UNITS, 1);
+
+	so_fork(test_sched_handler_24_1, 1);
+
+	sched_yield();
+	so_end();
+
+	basic_test(test_exec_status);
+}
+
+/*
+ * 25) Test task lookup
+ *
+ * tests if tasks are found by id while alive and not after they finished
+ */
+#define SO_TEST_25_TASKS 64
+
+static tid_t test_tids_25[SO_TEST_25_TASKS];
+static unsigned int test_exec_25_runs;
+
+static void test_sched_handler_25_worker(unsigned int dummy)
+{
+	test_exec_25_runs++;
+}
+
+static void test_sched_handler_25_master(unsigned int dummy)
+{
+	unsigned int i;
+
+	for (i = 0; i < SO_TEST_25_TASKS; i++) {
+		test_tids_25[i] = so_fork(test_sched_handler_25_worker, 0);
+		if (equal_tids(test_tids_25[i], INVALID_TID))
+			so_fail("cannot create new task");
+	}
+
+	/* every task is ready, so it should be found */
+	for (i = 0; i < SO_TEST_25_TASKS; i++)
+		if (so_set_priority(test_tids_25[i], 0) < 0)
+			so_fail("ready task not found");
+
+	/* let all the workers finish */
+	so_set_priority(get_tid(), 0);
+	so_yield();
+	if (test_exec_25_runs != SO_TEST_25_TASKS)
+		so_fail("workers did not finish");
+
+	for (i = 0; i < SO_TEST_25_TASKS; i++)
+		if (so_set_priority(test_tids_25[i], 0) == 0)
+			so_fail("finished task was changed");
+
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_25(void)
+{
+	test_exec_status = SO_TEST_FAIL;
+	test_exec_25_runs = 0;
+
+	so_init(SO_MAX_UNITS, 0);
+
+	so_fork(test_sched_handler_25_master, 1);
+
+	sched_yield();
+	so_end();
+
+	basic_test(test_exec_status);
+}
+
+/*
+ * 26) Test join
+ *
+ * tests if a task is parked until the tasks it joins terminate
+ */
+#define SO_TEST_26_TASKS 4
+
+static unsigned int test_exec_26_done;
+
+static void test_sched_handler_26_worker(unsigned int dummy)
+{
+	so_exec();
+	so_exec();
+	test_exec_26_done++;
+}
+
+static void test_sched_handler_26_master(unsigned int dummy)
+{
+	tid_t tids[SO_TEST_26_TASKS];
+	unsigned int i;
+
+	if (so_join(INVALID_TID) == 0)
+		so_fail("joined an invalid task");
+	if (so_join(get_tid()) == 0)
+		so_fail("joined myself");
+	if (so_wait_all(NULL, 1) == 0)
+		so_fail("joined missing tasks");
+
+	/* a lower priority task can only run while I am parked */
+	tids[0] = so_fork(test_sched_handler_26_worker, 0);
+	if (so_join(tids[0]) < 0)
+		so_fail("cannot join task");
+	if (test_exec_26_done != 1)
+		so_fail("join returned before the task terminated");
+
+	/* joining a terminated task returns immediately */
+	if (so_join(tids[0]) < 0)
+		so_fail("cannot join terminated task");
+
+	for (i = 0; i < SO_TEST_26_TASKS; i++)
+		tids[i] = so_fork(test_sched_handler_26_worker, 0);
+	if (so_wait_all(tids, SO_TEST_26_TASKS) < 0)
+		so_fail("cannot join tasks");
+	if (test_exec_26_done != SO_TEST_26_TASKS + 1)
+		so_fail("wait all returned before the tasks terminated");
+
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_26(void)
+{
+	test_exec_status = SO_TEST_FAIL;
+	test_exec_26_done = 0;
+
+	so_init(1, 0);
+
+	so_fork(test_sched_handler_26_master, 1);
+
+	sched_yield();
+	so_end();
+
+	basic_test(test_exec_status);
+}
+
+/*
+ * 27) Test fork argument
+ *
+ * tests if each task receives its own argument
+ */
+#define SO_TEST_27_TASKS 32
+
+struct so_test_27_arg_t {
+	unsigned int index;
+	unsigned int result;
+	tid_t tid;
+};
+
+static struct so_test_27_arg_t test_args_27[SO_TEST_27_TASKS];
+
+static void test_sched_handler_27_worker(void *arg)
+{
+	struct so_test_27_arg_t *task_arg = arg;
+
+	task_arg->tid = get_tid();
+	so_exec();
+	task_arg->result = task_arg->index * task_arg->index;
+}
+
+static void test_sched_handler_27_master(unsigned int dummy)
+{
+	tid_t tids[SO_TEST_27_TASKS];
+	unsigned int i;
+
+	if (so_fork_arg(NULL, NULL, 0) != INVALID_TID)
+		so_fail("invalid handler accepted");
+
+	for (i = 0; i < SO_TEST_27_TASKS; i++) {
+		test_args_27[i].index = i;
+		tids[i] = so_fork_arg(test_sched_handler_27_worker,
+				&test_args_27[i], get_rand(0, SO_MAX_PRIO));
+		if (equal_tids(tids[i], INVALID_TID))
+			so_fail("cannot create new task");
+	}
+
+	so_wait_all(tids, SO_TEST_27_TASKS);
+	for (i = 0; i < SO_TEST_27_TASKS; i++)
+		if (test_args_27[i].result != i * i ||
+			!equal_tids(test_args_27[i].tid, tids[i]))
+			so_fail("task received a wrong argument");
+
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_27(void)
+{
+	test_exec_status = SO_TEST_FAIL;
+
+	so_init(get_rand(1, SO_MAX_UNITS), 0);
+
+	so_fork(test_sched_handler_27_master, SO_MAX_PRIO);
+
+	sched_yield();
+	so_end();
+
+	basic_test(test_exec_status);
+}
+
+/*
+ * 28) Test inline tasks
+ *
+ * tests if short inline tasks reuse the thread of the finished ones
+ */
+#define SO_TEST_28_TASKS 16
+
+static tid_t test_hosts_28[SO_TEST_28_TASKS];
+static unsigned int test_exec_28_runs;
+static unsigned int test_exec_28_woken;
+
+static void test_sched_handler_28_worker(void *arg)
+{
+	tid_t *host = arg;
+
+	*host = get_tid();
+	so_exec();
+	test_exec_28_runs++;
+}
+
+static void test_sched_handler_28_wait(void *arg)
+{
+	so_wait(0);
+	test_exec_28_woken++;
+}
+
+static void test_sched_handler_28_signal(void *arg)
+{
+	if (so_signal(0) != 1)
+		so_fail("inline task was not waiting");
+}
+
+static void test_sched_handler_28_master(unsigned int dummy)
+{
+	tid_t tids[SO_TEST_28_TASKS];
+	so_task_attr_t attr;
+	unsigned int i;
+
+	so_task_attr_init(&attr);
+	attr.flags = SO_TASK_INLINE;
+
+	for (i = 0; i < SO_TEST_28_TASKS; i++) {
+		tids[i] = so_fork_attr(test_sched_handler_28_worker,
+				&test_hosts_28[i], &attr);
+		if (equal_tids(tids[i], INVALID_TID))
+			so_fail("cannot create new task");
+	}
+	so_wait_all(tids, SO_TEST_28_TASKS);
+
+	if (test_exec_28_runs != SO_TEST_28_TASKS)
+		so_fail("inline tasks did not run");
+
+	/* each task runs on the thread freed by the previous one */
+	for (i = 1; i < SO_TEST_28_TASKS; i++)
+		if (!equal_tids(test_hosts_28[i], test_hosts_28[0]))
+			so_fail("inline task did not reuse the thread");
+
+	/* inline tasks may still block */
+	tids[0] = so_fork_attr(test_sched_handler_28_wait, NULL, &attr);
+	tids[1] = so_fork_attr(test_sched_handler_28_signal, NULL, &attr);
+	so_wait_all(tids, 2);
+	if (test_exec_28_woken != 1)
+		so_fail("inline task was not woken");
+
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_28(void)
+{
+	test_exec_status = SO_TEST_FAIL;
+	test_exec_28_runs = 0;
+	test_exec_28_woken = 0;
+
+	so_init(SO_MAX_UNITS, 1);
+
+	so_fork(test_sched_handler_28_master, 1);
+
+	sched_yield();
+	so_end();
+
+	basic_test(test_exec_status);
+}
+
+/*
+ * 35) Test futures
+ *
+ * tests if a task computes a result recursively with futures
+ */
+#define SO_TEST_35_DEPTH	5
+
+static void *test_sched_handler_35_fib(void *arg)
+{
+	unsigned long n = (unsigned long) arg;
+	so_future_t first, second;
+	void *first_result, *second_result;
+
+	if (n < 2)
+		return arg;
+
+	first = so_fork_future(test_sched_handler_35_fib, (void *) (n - 1),
+			SO_MAX_PRIO);
+	second = so_fork_future(test_sched_handler_35_fib, (void *) (n - 2),
+			1);
+	if (equal_tids(first, INVALID_TID) || equal_tids(second, INVALID_TID))
+		so_fail("cannot create new task");
+
+	/* the first one has already finished, the second one has not */
+	if (so_future_get(first, &first_result) < 0 ||
+		so_future_get(second, &second_result) < 0)
+		so_fail("cannot get the result");
+
+	return (void *) ((unsigned long) first_result +
+			(unsigned long) second_result);
+}
+
+static void test_sched_handler_35_master(unsigned int dummy)
+{
+	so_future_t future;
+	void *result;
+
+	future = so_fork_future(test_sched_handler_35_fib,
+			(void *) SO_TEST_35_DEPTH, 1);
+	if (so_future_get(future, &result) < 0)
+		so_fail("cannot get the result");
+	if ((unsigned long) result != 5)
+		so_fail("wrong result");
+
+	/* the result can be taken again */
+	result = NULL;
+	if (so_future_get(future, &result) < 0 || (unsigned long) result != 5)
+		so_fail("result was lost");
+	if (so_future_get(INVALID_TID, &result) == 0)
+		so_fail("got the result of an invalid future");
+
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_35(void)
+{
+	test_exec_status = SO_TEST_FAIL;
+
+	so_init(SO_MAX_UNITS, 0);
+
+	so_fork(test_sched_handler_35_master, 1);
+
+	sched_yield();
+	so_end();
+
+	basic_test(test_exec_status);
+}
+
+/*
+ * 38) Test kill
+ *
+ * tests if a cancelled task never runs again, wherever it waits, and the
+ * mutexes it holds are handed over
+ */
+static so_task_mutex_t test_mutex_38;
+static unsigned int test_exec_38_ready_runs;
+static unsigned int test_exec_38_loops;
+static unsigned int test_exec_38_waiter_runs;
+
+static void test_sched_handler_38_ready(unsigned int priority)
+{
+	test_exec_38_ready_runs++;
+}
+
+static void test_sched_handler_38_runaway(unsigned int priority)
+{
+	for (;;) {
+		test_exec_38_loops++;
+		so_exec();
+	}
+}
+
+static void test_sched_handler_38_holder(unsigned int priority)
+{
+	so_task_mutex_lock(&test_mutex_38);
+	so_wait(0);
+	so_fail("cancelled task was woken");
+}
+
+static void test_sched_handler_38_waiter(unsigned int priority)
+{
+	if (so_task_mutex_lock(&test_mutex_38) < 0)
+		so_fail("cannot lock mutex");
+	test_exec_38_waiter_runs++;
+	so_task_mutex_unlock(&test_mutex_38);
+}
+
+static void test_sched_handler_38_self(unsigned int priority)
+{
+	so_kill(get_tid());
+	so_fail("task survived its own cancellation");
+}
+
+static void *test_sched_handler_38_future(void *arg)
+{
+	so_wait(0);
+	return arg;
+}
+
+static void test_sched_handler_38_master(unsigned int priority)
+{
+	tid_t tid;
+	unsigned int loops, i;
+	void *result;
+
+	/* a ready task is removed from the queue */
+	tid = so_fork(test_sched_handler_38_ready, 0);
+	if (so_kill(tid) < 0)
+		so_fail("cannot kill ready task");
+	if (so_kill(tid) == 0)
+		so_fail("killed a task twice");
+
+	/* a task preempted in the middle of its handler leaves it */
+	tid = so_fork(test_sched_handler_38_runaway, 1);
+	while (test_exec_38_loops == 0)
+		so_yield();
+	so_kill(tid);
+	loops = test_exec_38_loops;
+	for (i = 0; i < SO_MAX_UNITS; i++)
+		so_yield();
+	if (test_exec_38_ready_runs != 0 || test_exec_38_loops != loops)
+		so_fail("cancelled task ran");
+
+	/* a task waiting for I/O hands its mutex to the waiter */
+	tid = so_fork(test_sched_handler_38_holder, 2);
+	so_fork(test_sched_handler_38_waiter, 3);
+	if (test_exec_38_waiter_runs != 0)
+		so_fail("waiter got a held mutex");
+	so_kill(tid);
+	if (test_exec_38_waiter_runs != 1)
+		so_fail("mutex of the cancelled task was not released");
+	if (so_signal(0) != 0)
+		so_fail("cancelled task was still waiting");
+
+	/* the running task is cancelled at its next scheduling point */
+	tid = so_fork(test_sched_handler_38_self, 2);
+	if (so_join(tid) != SO_JOIN_CANCELLED)
+		so_fail("cannot join cancelled task");
+
+	tid = so_fork_future(test_sched_handler_38_future, NULL, 2);
+	so_kill(tid);
+	if (so_future_get(tid, &result) == 0)
+		so_fail("got the result of a cancelled task");
+
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_38(void)
+{
+	test_exec_status = SO_TEST_FAIL;
+	test_exec_38_ready_runs = 0;
+	test_exec_38_loops = 0;
+	test_exec_38_waiter_runs = 0;
+
+	so_init(get_rand(1, SO_MAX_UNITS), 1);
+	so_task_mutex_init(&test_mutex_38);
+
+	so_fork(test_sched_handler_38_master, 1);
+
+	sched_yield();
+	so_end();
+	so_task_mutex_destroy(&test_mutex_38);
+
+	basic_test(test_exec_status);
+}
+
+/*
+ * 39) Test budgets
+ *
+ * tests if a task that spent its budget is cancelled, demoted or marked
+ */
+#define SO_TEST_39_BUDGET	5
+
+static unsigned int test_exec_39_loops;
+
+static void test_sched_handler_39_loop(void *arg)
+{
+	unsigned int i;
+
+	for (i = 0; i < 2 * SO_TEST_39_BUDGET; i++) {
+		test_exec_39_loops++;
+		so_exec();
+	}
+}
+
+static void test_sched_handler_39_runaway(void *arg)
+{
+	for (;;) {
+		test_exec_39_loops++;
+		so_exec();
+	}
+}
+
+static tid_t test_fork_39(so_arg_handler *func, unsigned int action)
+{
+	so_task_attr_t attr;
+
+	so_task_attr_init(&attr);
+	attr.priority = 3;
+	attr.budget = SO_TEST_39_BUDGET;
+	attr.budget_action = action;
+	test_exec_39_loops = 0;
+	return so_fork_attr(func, NULL, &attr);
+}
+
+static void test_sched_handler_39_master(unsigned int priority)
+{
+	tid_t tid;
+
+	/* the runaway task is stopped when its budget is spent */
+	tid = test_fork_39(test_sched_handler_39_runaway, SO_BUDGET_CANCEL);
+	if (test_exec_39_loops != SO_TEST_39_BUDGET)
+		so_fail("task not cancelled after its budget");
+
+	/* the demoted task lets me run before it finishes */
+	tid = test_fork_39(test_sched_handler_39_loop, SO_BUDGET_DEMOTE);
+	if (test_exec_39_loops != SO_TEST_39_BUDGET)
+		so_fail("task not demoted after its budget");
+	if (so_budget_exceeded(tid) != 1)
+		so_fail("demoted task not marked");
+	so_join(tid);
+
+	/* a reported task only gets marked */
+	tid = test_fork_39(test_sched_handler_39_loop, SO_BUDGET_REPORT);
+	if (test_exec_39_loops != 2 * SO_TEST_39_BUDGET)
+		so_fail("reported task was stopped");
+	if (so_budget_exceeded(tid) != 1)
+		so_fail("task not marked after its budget");
+
+	tid = so_fork_arg(test_sched_handler_39_loop, NULL, 3);
+	if (so_budget_exceeded(tid) != 0)
+		so_fail("task with no budget marked");
+
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_39(void)
+{
+	test_exec_status = SO_TEST_FAIL;
+
+	so_init(get_rand(1, SO_MAX_UNITS), 0);
+
+	so_fork(test_sched_handler_39_master, 1);
+
+	sched_yield();
+	so_end();
+
+	basic_test(test_exec_status);
+}
+
+
+/*
+ * 40) Test task groups
+ *
+ * tests if groups share the time by their weights and keep to their quota
+ */
+#define SO_TEST_40_UNITS	400
+#define SO_TEST_40_TASKS	4
+
+static unsigned int test_exec_40_units[2];
+static unsigned int test_exec_40_total;
+
+static void test_sched_handler_40_share(void *arg)
+{
+	unsigned int *units = arg;
+
+	while (test_exec_40_total < SO_TEST_40_UNITS) {
+		test_exec_40_total++;
+		(*units)++;
+		so_exec();
+	}
+}
+
+static tid_t test_fork_40(so_arg_handler *func, void *arg,
+		so_task_group_t *group)
+{
+	so_task_attr_t attr;
+
+	so_task_attr_init(&attr);
+	attr.priority = 2;
+	attr.group = group;
+	return so_fork_attr(func, arg, &attr);
+}
+
+static void test_sched_handler_40_master(unsigned int priority)
+{
+	so_task_group_t *heavy, *light, *child;
+	tid_t tids[SO_TEST_40_TASKS + 1];
+	unsigned int i;
+
+	heavy = so_task_group_create(NULL, 3 * SO_GROUP_DEFAULT_WEIGHT);
+	light = so_task_group_create(NULL, SO_GROUP_DEFAULT_WEIGHT);
+	if (heavy == NULL || light == NULL)
+		so_fail("cannot create groups");
+	if (so_task_group_create(heavy, SO_GROUP_MAX_WEIGHT + 1) != NULL)
+		so_fail("group created with a wrong weight");
+	if (so_task_group_set_quota(light, 2, 1) >= 0)
+		so_fail("quota larger than its period");
+
+	/* more tasks do not get the light group a larger share */
+	test_exec_40_total = 0;
+	tids[0] = test_fork_40(test_sched_handler_40_share,
+			&test_exec_40_units[0], heavy);
+	for (i = 1; i <= SO_TEST_40_TASKS; i++)
+		tids[i] = test_fork_40(test_sched_handler_40_share,
+				&test_exec_40_units[1], light);
+	if (so_task_group_destroy(light) >= 0)
+		so_fail("group with tasks destroyed");
+	for (i = 0; i <= SO_TEST_40_TASKS; i++)
+		so_join(tids[i]);
+
+	if (test_exec_40_units[0] < 2 * test_exec_40_units[1] ||
+		test_exec_40_units[0] > 4 * test_exec_40_units[1])
+		so_fail("groups not sharing by weight");
+
+	/* the group over its quota runs only one fifth of the time */
+	test_exec_40_total = 0;
+	test_exec_40_units[0] = 0;
+	test_exec_40_units[1] = 0;
+	if (so_task_group_set_quota(light, 2, 10) != 0)
+		so_fail("cannot set quota");
+	if (so_task_group_set_quota(heavy, 0, 0) != 0)
+		so_fail("cannot remove quota");
+	tids[0] = test_fork_40(test_sched_handler_40_share,
+			&test_exec_40_units[0], heavy);
+	tids[1] = test_fork_40(test_sched_handler_40_share,
+			&test_exec_40_units[1], light);
+	so_join(tids[0]);
+	so_join(tids[1]);
+
+	if (test_exec_40_units[1] == 0 ||
+		3 * test_exec_40_units[1] > test_exec_40_units[0])
+		so_fail("group not throttled by its quota");
+
+	child = so_task_group_create(heavy, SO_GROUP_DEFAULT_WEIGHT);
+	if (child == NULL)
+		so_fail("cannot create subgroup");
+	if (so_task_group_destroy(heavy) >= 0)
+		so_fail("group with subgroups destroyed");
+	if (so_task_group_destroy(child) != 0 ||
+		so_task_group_destroy(heavy) != 0 ||
+		so_task_group_destroy(light) != 0)
+		so_fail("cannot destroy groups");
+
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_40(void)
+{
+	test_exec_status = SO_TEST_FAIL;
+
+	so_init(get_rand(1, SO_MAX_UNITS), 0);
+
+	so_fork(test_sched_handler_40_master, 1);
+
+	sched_yield();
+	so_end();
+
+	basic_test(test_exec_status);
+}
+
+
+/*
+ * 41) Test scheduler instances
+ *
+ * tests if the tasks of independent schedulers use only their scheduler
+ */
+#define SO_TEST_41_LOOPS	20
+
+static unsigned int test_exec_41_loops[2];
+static unsigned int test_exec_41_joined;
+static unsigned int test_exec_41_refused;
+
+static void test_sched_handler_41_child(void *arg)
+{
+	unsigned int *loops = arg;
+	unsigned int i;
+
+	for (i = 0; i < SO_TEST_41_LOOPS; i++) {
+		(*loops)++;
+		so_exec();
+	}
+}
+
+static void test_sched_handler_41_parent(void *arg)
+{
+	tid_t tid;
+
+	/* a task cannot leave its scheduler */
+	if (so_sched_use(NULL) == NULL)
+		__sync_fetch_and_add(&test_exec_41_refused, 1);
+
+	/* the child is forked in the scheduler of its parent */
+	tid = so_fork_arg(test_sched_handler_41_child, arg, 2);
+	if (so_join(tid) == 0)
+		__sync_fetch_and_add(&test_exec_41_joined, 1);
+}
+
+void test_sched_41(void)
+{
+	so_sched_t *first, *second, *previous;
+	tid_t tid;
+
+	test_exec_status = SO_TEST_FAIL;
+	test_exec_41_joined = 0;
+	test_exec_41_refused = 0;
+
+	if (so_init(get_rand(1, SO_MAX_UNITS), 0) < 0)
+		so_fail("cannot init the default scheduler");
+	first = so_sched_create(get_rand(1, SO_MAX_UNITS), 0);
+	second = so_sched_create(get_rand(1, SO_MAX_UNITS), 0);
+	if (first == NULL || second == NULL)
+		so_fail("cannot create schedulers");
+	if (so_sched_create(0, 0) != NULL)
+		so_fail("scheduler created with a wrong quantum");
+
+	previous = so_sched_use(first);
+	so_fork_arg(test_sched_handler_41_parent, &test_exec_41_loops[0], 1);
+	so_sched_use(second);
+	tid = so_fork_arg(test_sched_handler_41_parent,
+			&test_exec_41_loops[1], 1);
+	if (so_budget_exceeded(tid) != 0)
+		so_fail("task not found in its scheduler");
+
+	/* the tasks of one scheduler are not seen by the others */
+	so_sched_use(previous);
+	if (so_budget_exceeded(tid) >= 0)
+		so_fail("task found in another scheduler");
+	if (so_init(1, 0) == 0)
+		so_fail("default scheduler initialized twice");
+
+	so_sched_destroy(first);
+	so_sched_destroy(second);
+	so_end();
+
+	if (test_exec_41_joined == 2 && test_exec_41_refused == 2 &&
+		test_exec_41_loops[0] == SO_TEST_41_LOOPS &&
+		test_exec_41_loops[1] == SO_TEST_41_LOOPS)
+		test_exec_status = SO_TEST_SUCCESS;
+
+	basic_test(test_exec_status);
+}
+
+/*
+ * 42) Test process tasks
+ *
+ * tests if a task run in its own process is scheduled like the others and
+ * if its crash or cancellation leaves the scheduler running
+ */
+static unsigned int test_exec_42_value;
+
+static void test_sched_handler_42_waiter(void *arg)
+{
+	/* the process has its own copy of the memory */
+	test_exec_42_value = 1;
+	so_exec();
+	so_wait(0);
+}
+
+static void test_sched_handler_42_crash(void *arg)
+{
+	so_exec();
+	raise(SIGKILL);
+}
+
+static void test_sched_handler_42_runaway(void *arg)
+{
+	for (;;)
+		so_exec();
+}
+
+static tid_t test_fork_42(so_arg_handler *func, unsigned int priority)
+{
+	so_task_attr_t attr;
+
+	so_task_attr_init(&attr);
+	attr.priority = priority;
+	attr.flags = SO_TASK_PROCESS;
+	return so_fork_attr(func, NULL, &attr);
+}
+
+static void test_sched_handler_42_master(unsigned int priority)
+{
+	tid_t tid;
+	unsigned int i;
+
+	tid = test_fork_42(test_sched_handler_42_waiter, 2);
+	if (so_signal(0) != 1)
+		so_fail("process task not waiting for the device");
+	if (so_join(tid) < 0)
+		so_fail("cannot join process task");
+	if (test_exec_42_value != 0)
+		so_fail("process task shares the memory");
+
+	tid = test_fork_42(test_sched_handler_42_crash, 2);
+	if (so_join(tid) < 0)
+		so_fail("cannot join crashed process task");
+
+	tid = test_fork_42(test_sched_handler_42_runaway, priority);
+	for (i = 0; i < 4; i++)
+		so_yield();
+	if (so_kill(tid) < 0)
+		so_fail("cannot kill process task");
+	if (so_join(tid) < 0)
+		so_fail("cannot join killed process task");
+
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_42(void)
+{
+	test_exec_status = SO_TEST_FAIL;
+	test_exec_42_value = 0;
+
+	so_init(get_rand(1, SO_MAX_UNITS), 1);
+
+	so_fork(test_sched_handler_42_master, 1);
+
+	sched_yield();
+	so_end();
+
+	basic_test(test_exec_status);
+}
+
+
+/*
+ * 43) Test cpu affinity
+ *
+ * tests if the threads of the tasks run on the cpu chosen for them and if
+ * a task whose thread cannot be pinned is not forked
+ */
+#define SO_TEST_43_LOOPS	10
+/* last cpu of a cpu set, which the tests do not run on */
+#define SO_TEST_43_FAR_CPU	1023
+
+static unsigned int test_exec_43_other_cpu;
+
+static void test_sched_handler_43_loop(void *arg)
+{
+	unsigned int i;
+
+	for (i = 0; i < SO_TEST_43_LOOPS; i++) {
+#ifdef __linux__
+		if (sched_getcpu() != 0)
+			test_exec_43_other_cpu++;
+#endif
+		so_exec();
+	}
+}
+
+static void test_sched_handler_43_master(unsigned int priority)
+{
+	so_task_attr_t attr;
+	tid_t tids[2];
+
+	tids[0] = so_fork_arg(test_sched_handler_43_loop, NULL, priority);
+
+	/* inline tasks get their thread pinned when they are dispatched */
+	so_task_attr_init(&attr);
+	attr.priority = priority;
+	attr.flags = SO_TASK_INLINE;
+	tids[1] = so_fork_attr(test_sched_handler_43_loop, NULL, &attr);
+	so_wait_all(tids, 2);
+
+	if (test_exec_43_other_cpu == 0)
+		test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_43(void)
+{
+	test_exec_status = SO_TEST_FAIL;
+	test_exec_43_other_cpu = 0;
+
+	so_init(get_rand(1, SO_MAX_UNITS), 0);
+
+	if (so_sched_set_cpu(-2) >= 0)
+		so_fail("wrong cpu accepted");
+	if (so_sched_set_cpu(1 << 20) >= 0)
+		so_fail("cpu out of any cpu set accepted");
+
+#ifdef __linux__
+	/* a task which cannot be pinned is not forked */
+	if (so_sched_set_cpu(SO_TEST_43_FAR_CPU) < 0)
+		so_fail("cpu index refused");
+	if (so_fork(test_sched_handler_43_master, 1) != INVALID_TID)
+		so_fail("task forked on a cpu it cannot run on");
+#endif
+
+	if (so_sched_set_cpu(0) < 0)
+		so_fail("cannot pin the tasks");
+
+	so_fork(test_sched_handler_43_master, 1);
+
+	sched_yield();
+	so_end();
+
+	basic_test(test_exec_status);
+}
+
+
+/*
+ * 44) Test task migration
+ *
+ * tests if ready tasks are moved to another scheduler and run there
+ */
+#define SO_TEST_44_TASKS	3
+
+static so_sched_t *test_sched_44_to;
+static unsigned int test_exec_44_moved_runs;
+
+static void test_sched_handler_44_worker(void *arg)
+{
+	so_exec();
+
+	/** the thread of a moved task uses the scheduler it was moved to,
+	 * the only one a task may choose
+	 */
+	if (so_sched_use(test_sched_44_to) == test_sched_44_to)
+		__sync_fetch_and_add(&test_exec_44_moved_runs, 1);
+}
+
+static void test_sched_handler_44_master(unsigned int priority)
+{
+	tid_t tids[SO_TEST_44_TASKS];
+	unsigned int i;
+
+	/* the workers wait behind me */
+	for (i = 0; i < SO_TEST_44_TASKS; i++)
+		tids[i] = so_fork_arg(test_sched_handler_44_worker, NULL, 0);
+	if (so_sched_ready_tasks(NULL) != SO_TEST_44_TASKS)
+		so_fail("wrong number of ready tasks");
+
+	if (so_sched_migrate(get_tid(), test_sched_44_to) >= 0)
+		so_fail("running task moved");
+	if (so_sched_migrate(tids[0], test_sched_44_to) < 0)
+		so_fail("cannot move ready task");
+	if (so_sched_drain(test_sched_44_to) != SO_TEST_44_TASKS - 1)
+		so_fail("cannot move all ready tasks");
+	if (so_sched_ready_tasks(NULL) != 0)
+		so_fail("moved tasks still ready");
+	if (so_join(tids[1]) >= 0)
+		so_fail("moved task joined");
+
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_44(void)
+{
+	so_sched_t *from, *previous;
+
+	test_exec_status = SO_TEST_FAIL;
+	test_exec_44_moved_runs = 0;
+
+	from = so_sched_create(get_rand(1, SO_MAX_UNITS), 0);
+	test_sched_44_to = so_sched_create(get_rand(1, SO_MAX_UNITS), 0);
+	if (from == NULL || test_sched_44_to == NULL)
+		so_fail("cannot create schedulers");
+
+	previous = so_sched_use(from);
+	so_fork(test_sched_handler_44_master, 1);
+	so_sched_destroy(from);
+	so_sched_destroy(test_sched_44_to);
+	so_sched_use(previous);
+
+	if (test_exec_44_moved_runs != SO_TEST_44_TASKS)
+		test_exec_status = SO_TEST_FAIL;
+
+	basic_test(test_exec_status);
+}
+
+
+/*
+ * 45) Test load balancing
+ *
+ * tests if ready tasks are spread over idle schedulers, except the ones
+ * not allowed to move
+ */
+#define SO_TEST_45_TASKS	6
+#define SO_TEST_45_SCHEDS	3
+#define SO_TEST_45_LOOPS	5
+
+static so_sched_t *test_scheds_45[SO_TEST_45_SCHEDS];
+static unsigned int test_exec_45_runs;
+static unsigned int test_exec_45_pinned_moved;
+
+static void test_sched_handler_45_worker(void *arg)
+{
+	unsigned int i;
+
+	for (i = 0; i < SO_TEST_45_LOOPS; i++)
+		so_exec();
+
+	/* a task may choose only its own scheduler */
+	if (arg != NULL && so_sched_use(test_scheds_45[0]) == NULL)
+		test_exec_45_pinned_moved = 1;
+	__sync_fetch_and_add(&test_exec_45_runs, 1);
+}
+
+static void test_sched_handler_45_master(unsigned int priority)
+{
+	so_task_attr_t attr;
+	unsigned int i;
+
+	/* the workers wait behind me, one of them may run only on cpu 1 */
+	for (i = 0; i < SO_TEST_45_TASKS; i++)
+		so_fork_arg(test_sched_handler_45_worker, NULL, 0);
+	so_task_attr_init(&attr);
+	attr.priority = 0;
+	attr.cpu_mask = 1UL << 1;
+	so_fork_attr(test_sched_handler_45_worker, &attr, &attr);
+
+	/* a load of 7 is split as 4 and 3 */
+	if (so_sched_balance(test_scheds_45, SO_TEST_45_SCHEDS) != 3)
+		so_fail("wrong number of tasks moved");
+	for (i = 0; i < 2 * SO_TEST_45_TASKS; i++)
+		if (so_sched_balance(test_scheds_45, SO_TEST_45_SCHEDS) < 0)
+			so_fail("cannot balance");
+	if (so_sched_ready_tasks(NULL) < 1)
+		so_fail("task moved against its cpu mask");
+
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_45(void)
+{
+	so_sched_t *previous;
+	unsigned int i;
+
+	test_exec_status = SO_TEST_FAIL;
+	test_exec_45_runs = 0;
+	test_exec_45_pinned_moved = 0;
+
+	for (i = 0; i < SO_TEST_45_SCHEDS; i++) {
+		test_scheds_45[i] = so_sched_create(
+				get_rand(1, SO_MAX_UNITS), 0);
+		if (test_scheds_45[i] == NULL)
+			so_fail("cannot create schedulers");
+	}
+	if (so_sched_balance(test_scheds_45, 0) >= 0)
+		so_fail("empty set balanced");
+
+	previous = so_sched_use(test_scheds_45[0]);
+	so_fork(test_sched_handler_45_master, 1);
+	for (i = 0; i < SO_TEST_45_SCHEDS; i++)
+		so_sched_destroy(test_scheds_45[i]);
+	so_sched_use(previous);
+
+	if (test_exec_45_runs != SO_TEST_45_TASKS + 1 ||
+		test_exec_45_pinned_moved != 0)
+		test_exec_status = SO_TEST_FAIL;
+
+	basic_test(test_exec_status);
+}
+
+
+/*
+ * 46) Test gang groups
+ *
+ * tests if the tasks of a gang group run one after another
+ */
+#define SO_TEST_46_MEMBERS	3
+#define SO_TEST_46_LOOPS	6
+#define SO_TEST_46_OTHER	SO_TEST_46_MEMBERS
+#define SO_TEST_46_LOG		(4 * (SO_TEST_46_MEMBERS + 1) * SO_TEST_46_LOOPS)
+
+static unsigned int test_exec_46_log[SO_TEST_46_LOG];
+static unsigned int test_exec_46_entries;
+static unsigned int test_exec_46_prios[SO_TEST_46_MEMBERS];
+
+static void test_sched_46_log(unsigned int who)
+{
+	if (test_exec_46_entries < SO_TEST_46_LOG)
+		test_exec_46_log[test_exec_46_entries++] = who;
+}
+
+static void test_sched_handler_46_member(void *arg)
+{
+	unsigned int i;
+
+	so_wait(0);
+	for (i = 0; i < SO_TEST_46_LOOPS; i++) {
+		test_sched_46_log(*(unsigned int *)arg);
+		so_exec();
+	}
+}
+
+static void test_sched_handler_46_other(void *arg)
+{
+	unsigned int i;
+
+	for (i = 0; i < SO_TEST_46_LOOPS; i++) {
+		test_sched_46_log(SO_TEST_46_OTHER);
+		so_exec();
+	}
+}
+
+static void test_sched_handler_46_master(unsigned int priority)
+{
+	static unsigned int ids[SO_TEST_46_MEMBERS];
+	tid_t tids[SO_TEST_46_MEMBERS + 1];
+	so_task_group_t *gang, *other;
+	unsigned int seen[SO_TEST_46_MEMBERS];
+	so_task_attr_t attr;
+	unsigned int i, j, run;
+
+	gang = so_task_group_create(NULL, SO_GROUP_DEFAULT_WEIGHT);
+	other = so_task_group_create(NULL, SO_GROUP_DEFAULT_WEIGHT);
+	if (so_task_group_set_gang(gang, 1) < 0)
+		so_fail("cannot make a gang");
+
+	so_task_attr_init(&attr);
+	attr.group = gang;
+	for (i = 0; i < SO_TEST_46_MEMBERS; i++) {
+		ids[i] = i;
+		attr.priority = test_exec_46_prios[i];
+		tids[i] = so_fork_attr(test_sched_handler_46_member, &ids[i],
+				&attr);
+	}
+	attr.priority = priority;
+	attr.group = other;
+	tids[i] = so_fork_attr(test_sched_handler_46_other, NULL, &attr);
+
+	/* the gang starts with all its tasks ready */
+	so_signal(0);
+	so_wait_all(tids, SO_TEST_46_MEMBERS + 1);
+
+	/* each run of the gang has all the members, in turns */
+	for (i = 0; i < test_exec_46_entries; i += run) {
+		for (run = 0; i + run < test_exec_46_entries &&
+			test_exec_46_log[i + run] != SO_TEST_46_OTHER; run++)
+			;
+		if (run == 0) {
+			run = 1;
+			continue;
+		}
+		if (run % SO_TEST_46_MEMBERS != 0)
+			so_fail("gang interrupted");
+		for (j = 0; j < run; j++) {
+			if (j % SO_TEST_46_MEMBERS == 0)
+				memset(seen, 0, sizeof(seen));
+			if (seen[test_exec_46_log[i + j]]++)
+				so_fail("member run twice in a turn");
+		}
+	}
+
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_46(void)
+{
+	unsigned int i;
+
+	test_exec_status = SO_TEST_FAIL;
+	test_exec_46_entries = 0;
+	for (i = 0; i < SO_TEST_46_MEMBERS; i++)
+		test_exec_46_prios[i] = 1;
+
+	so_init(1, 1);
+
+	so_fork(test_sched_handler_46_master, 1);
+
+	sched_yield();
+	so_end();
+
+	basic_test(test_exec_status);
+}
+
+/*
+ * 47) Test wake affine
+ *
+ * tests if a task woken by so_signal runs before the ready tasks with its
+ * priority when wake affine placement is on
+ */
+#define SO_TEST_47_WAITER	1
+#define SO_TEST_47_PEER		2
+
+static unsigned int test_exec_47_log[2];
+static unsigned int test_exec_47_entries;
+
+static void test_sched_handler_47_waiter(unsigned int dummy)
+{
+	so_wait(0);
+	if (test_exec_47_entries < 2)
+		test_exec_47_log[test_exec_47_entries++] = SO_TEST_47_WAITER;
+}
+
+static void test_sched_handler_47_peer(unsigned int dummy)
+{
+	if (test_exec_47_entries < 2)
+		test_exec_47_log[test_exec_47_entries++] = SO_TEST_47_PEER;
+}
+
+static void test_sched_handler_47_master(unsigned int dummy)
+{
+	tid_t tids[2];
+
+	/* the waiter preempts me and blocks before so_fork returns */
+	tids[0] = so_fork(test_sched_handler_47_waiter, 2);
+	if (so_set_priority(tids[0], 0) < 0)
+		so_fail("cannot lower the waiter");
+	tids[1] = so_fork(test_sched_handler_47_peer, 0);
+
+	if (so_sched_set_wake_affine(1) < 0)
+		so_fail("cannot enable wake affine");
+	if (so_signal(0) != 1)
+		so_fail("waiter not woken");
+
+	/* let both run */
+	so_set_priority(get_tid(), 0);
+	so_wait_all(tids, 2);
+
+	if (test_exec_47_entries != 2 ||
+		test_exec_47_log[0] != SO_TEST_47_WAITER ||
+		test_exec_47_log[1] != SO_TEST_47_PEER)
+		so_fail("woken task not placed in front");
+
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_47(void)
+{
+	test_exec_status = SO_TEST_FAIL;
+	test_exec_47_entries = 0;
+
+	if (so_sched_set_wake_affine(1) == 0)
+		so_fail("wake affine set before init");
+
+	so_init(SO_MAX_UNITS, 1);
+
+	so_fork(test_sched_handler_47_master, 1);
+
+	sched_yield();
+	so_end();
+
+	basic_test(test_exec_status);
+}
+
+/*
+ * 48) Test quanta
+ *
+ * tests if the tasks get the time quantum of their priority, set at init
+ * and at runtime
+ */
+#define SO_TEST_48_LOOPS	6
+#define SO_TEST_48_LOG		(2 * SO_TEST_48_LOOPS)
+
+static unsigned int test_exec_48_log[SO_TEST_48_LOG];
+static unsigned int test_exec_48_entries;
+
+static void test_sched_handler_48_worker(void *arg)
+{
+	unsigned int i;
+
+	for (i = 0; i < SO_TEST_48_LOOPS; i++) {
+		if (test_exec_48_entries < SO_TEST_48_LOG)
+			test_exec_48_log[test_exec_48_entries++] =
+				*(unsigned int *)arg;
+		so_exec();
+	}
+}
+
+/* runs two workers with priority 0 and checks they take turns of q_time */
+static void test_sched_48_turns(unsigned int q_time)
+{
+	static unsigned int ids[2] = { 0, 1 };
+	tid_t tids[2];
+	unsigned int i;
+
+	test_exec_48_entries = 0;
+	tids[0] = so_fork_arg(test_sched_handler_48_worker, &ids[0], 0);
+	tids[1] = so_fork_arg(test_sched_handler_48_worker, &ids[1], 0);
+	so_wait_all(tids, 2);
+
+	if (test_exec_48_entries != SO_TEST_48_LOG)
+		so_fail("workers did not finish");
+	for (i = 0; i < SO_TEST_48_LOG; i++)
+		if (test_exec_48_log[i] != (i / q_time) % 2)
+			so_fail("quantum not used");
+}
+
+static void test_sched_handler_48_master(unsigned int dummy)
+{
+	if (so_sched_set_quantum(SO_MAX_PRIO + 1, 1) == 0)
+		so_fail("invalid priority accepted");
+	if (so_sched_set_quantum(0, 0) == 0)
+		so_fail("empty quantum accepted");
+
+	test_sched_48_turns(3);
+
+	if (so_sched_set_quantum(0, 2) < 0)
+		so_fail("cannot set quantum");
+	test_sched_48_turns(2);
+
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_48(void)
+{
+	unsigned int quanta[SO_MAX_PRIO + 1] = { 3, 1, 1, 1, 1, 1 };
+	unsigned int empty[SO_MAX_PRIO + 1] = { 3, 1, 0, 1, 1, 1 };
+
+	test_exec_status = SO_TEST_FAIL;
+
+	if (so_init_quanta(empty, 1) == 0)
+		so_fail("empty quantum accepted");
+	if (so_init_quanta(quanta, 1) < 0)
+		so_fail("cannot init");
+
+	so_fork(test_sched_handler_48_master, 1);
+
+	sched_yield();
+	so_end();
+
+	basic_test(test_exec_status);
+}
+
+/*
+ * 49) Test adaptive quantum
+ *
+ * tests if the adaptive quantum grows while the tasks do nothing but switch
+ * and if the new tasks get it
+ */
+#define SO_TEST_49_LOOPS	2000
+#define SO_TEST_49_MAX		16
+
+static void test_sched_handler_49_worker(unsigned int dummy)
+{
+	unsigned int i;
+
+	for (i = 0; i < SO_TEST_49_LOOPS; i++)
+		so_exec();
+}
+
+static void test_sched_handler_49_master(unsigned int dummy)
+{
+	tid_t tids[2];
+
+	if (so_sched_set_adaptive(0, SO_TEST_49_MAX, 1) == 0)
+		so_fail("empty quantum accepted");
+	if (so_sched_set_adaptive(SO_TEST_49_MAX, 1, 1) == 0)
+		so_fail("invalid bounds accepted");
+	if (so_sched_set_adaptive(1, SO_TEST_49_MAX, 100) == 0)
+		so_fail("invalid target accepted");
+	if (so_sched_get_quantum(SO_MAX_PRIO + 1) != 0)
+		so_fail("invalid priority accepted");
+
+	if (so_sched_set_adaptive(1, SO_TEST_49_MAX, 1) < 0)
+		so_fail("cannot make the quantum adaptive");
+	if (so_sched_get_quantum(0) != 1)
+		so_fail("adaptive quantum not started at its lower bound");
+
+	/* the switches take almost all the time */
+	tids[0] = so_fork(test_sched_handler_49_worker, 0);
+	tids[1] = so_fork(test_sched_handler_49_worker, 0);
+	so_wait_all(tids, 2);
+
+	if (so_sched_get_quantum(0) != SO_TEST_49_MAX)
+		so_fail("adaptive quantum did not grow");
+
+	/* a new task starts with the adaptive quantum */
+	if (so_sched_set_adaptive(3, 3, 1) < 0)
+		so_fail("cannot bound the adaptive quantum");
+	test_sched_48_turns(3);
+
+	if (so_sched_set_adaptive(0, 0, 0) < 0)
+		so_fail("cannot turn the adaptive quantum off");
+	if (so_sched_get_quantum(0) != SO_MAX_UNITS)
+		so_fail("quantum of the priority not restored");
+
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_49(void)
+{
+	test_exec_status = SO_TEST_FAIL;
+
+	so_init(SO_MAX_UNITS, 1);
+
+	so_fork(test_sched_handler_49_master, 1);
+
+	sched_yield();
+	so_end();
+
+	basic_test(test_exec_status);
+}
+
+/*
+ * 50) Test carry over
+ *
+ * tests if a task preempted by a higher priority keeps the rest of its
+ * quantum and its place
+ */
+#define SO_TEST_50_QUANTUM	4
+#define SO_TEST_50_FIRST	1
+#define SO_TEST_50_SECOND	2
+#define SO_TEST_50_LOG		(SO_TEST_50_QUANTUM + 2)
+
+static unsigned int test_exec_50_log[SO_TEST_50_LOG];
+static unsigned int test_exec_50_entries;
+
+static void test_sched_50_log(unsigned int who)
+{
+	if (test_exec_50_entries < SO_TEST_50_LOG)
+		test_exec_50_log[test_exec_50_entries++] = who;
+}
+
+static void test_sched_handler_50_first(unsigned int dummy)
+{
+	unsigned int i;
+
+	/* the master preempts me after the first unit of my quantum */
+	test_sched_50_log(SO_TEST_50_FIRST);
+	so_signal(0);
+	for (i = 1; i < SO_TEST_50_QUANTUM; i++) {
+		test_sched_50_log(SO_TEST_50_FIRST);
+		so_exec();
+	}
+	test_sched_50_log(SO_TEST_50_FIRST);
+}
+
+static void test_sched_handler_50_second(unsigned int dummy)
+{
+	test_sched_50_log(SO_TEST_50_SECOND);
+	so_signal(0);
+}
+
+static void test_sched_handler_50_master(unsigned int dummy)
+{
+	unsigned int expected[SO_TEST_50_LOG] = {
+		SO_TEST_50_FIRST, SO_TEST_50_FIRST,
+		SO_TEST_50_FIRST, SO_TEST_50_FIRST,
+		SO_TEST_50_SECOND, SO_TEST_50_FIRST
+	};
+	tid_t tids[2];
+	unsigned int i;
+
+	if (so_sched_set_carry_over(1) < 0)
+		so_fail("cannot enable carry over");
+
+	tids[0] = so_fork(test_sched_handler_50_first, 0);
+	tids[1] = so_fork(test_sched_handler_50_second, 0);
+	so_wait(0);
+	so_wait(0);
+	so_wait_all(tids, 2);
+
+	if (test_exec_50_entries != SO_TEST_50_LOG)
+		so_fail("tasks did not finish");
+	for (i = 0; i < SO_TEST_50_LOG; i++)
+		if (test_exec_50_log[i] != expected[i])
+			so_fail("quantum not carried over");
+
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_50(void)
+{
+	test_exec_status = SO_TEST_FAIL;
+	test_exec_50_entries = 0;
+
+	if (so_sched_set_carry_over(1) == 0)
+		so_fail("carry over set before init");
+
+	so_init(SO_TEST_50_QUANTUM, 1);
+
+	so_fork(test_sched_handler_50_master, 2);
+
+	sched_yield();
+	so_end();
+
+	basic_test(test_exec_status);
+}
+
+/*
+ * 52) Test gang rotation
+ *
+ * tests if the tasks of a gang group take turns whatever their priorities
+ */
+void test_sched_52(void)
+{
+	unsigned int i;
+
+	test_exec_status = SO_TEST_FAIL;
+	test_exec_46_entries = 0;
+	for (i = 0; i < SO_TEST_46_MEMBERS; i++)
+		test_exec_46_prios[i] = SO_TEST_46_MEMBERS - i;
+
+	so_init(1, 1);
+
+	so_fork(test_sched_handler_46_master, 1);
+
+	sched_yield();
+	so_end();
+
+	basic_test(test_exec_status);
+}
+
+
+/*
+ * 55) Test kill with adaptive quantum
+ *
+ * tests if a waiting task cancelled right before the scheduler ends does
+ * not account a switch, which would lock the ending scheduler
+ */
+#define SO_TEST_55_ROUNDS	200
+
+static unsigned int test_exec_55_rounds;
+
+static void test_sched_handler_55_waiter(unsigned int dummy)
+{
+	so_wait(0);
+	so_fail("cancelled task was woken");
+}
+
+static void test_sched_handler_55_master(unsigned int dummy)
+{
+	tid_t tid;
+
+	if (so_sched_set_adaptive(1, SO_MAX_UNITS, 1) < 0)
+		so_fail("cannot make the quantum adaptive");
+
+	/* the scheduler ends as soon as this task terminates */
+	tid = so_fork(test_sched_handler_55_waiter, 2);
+	if (so_kill(tid) < 0)
+		so_fail("cannot kill the waiting task");
+	test_exec_55_rounds++;
+}
+
+void test_sched_55(void)
+{
+	unsigned int i;
+
+	test_exec_55_rounds = 0;
+
+	for (i = 0; i < SO_TEST_55_ROUNDS; i++) {
+		so_init(SO_MAX_UNITS, 1);
+		so_fork(test_sched_handler_55_master, 1);
+		so_end();
+	}
+
+	basic_test(test_exec_55_rounds == SO_TEST_55_ROUNDS ?
+		SO_TEST_SUCCESS : SO_TEST_FAIL);
+}
+
+
+/*
+ * 57) Test inline ids across schedulers
+ *
+ * tests if inline tasks forked in different schedulers get different ids
+ */
+#define SO_TEST_57_TASKS	8
+
+static tid_t test_exec_57_tids[2 * SO_TEST_57_TASKS];
+
+static void test_sched_handler_57_child(void *arg)
+{
+	so_exec();
+}
+
+static void test_sched_handler_57_master(void *arg)
+{
+	tid_t *tids = arg;
+	so_task_attr_t attr;
+	unsigned int i;
+
+	so_task_attr_init(&attr);
+	attr.flags = SO_TASK_INLINE;
+	for (i = 0; i < SO_TEST_57_TASKS; i++)
+		tids[i] = so_fork_attr(test_sched_handler_57_child, NULL,
+				&attr);
+}
+
+void test_sched_57(void)
+{
+	so_sched_t *scheds[2], *previous;
+	unsigned int i, j;
+
+	test_exec_status = SO_TEST_FAIL;
+
+	scheds[0] = so_sched_create(SO_MAX_UNITS, 0);
+	scheds[1] = so_sched_create(SO_MAX_UNITS, 0);
+	if (scheds[0] == NULL || scheds[1] == NULL)
+		so_fail("cannot create schedulers");
+
+	previous = so_sched_use(scheds[0]);
+	so_fork_arg(test_sched_handler_57_master, test_exec_57_tids, 1);
+	so_sched_use(scheds[1]);
+	so_fork_arg(test_sched_handler_57_master,
+			test_exec_57_tids + SO_TEST_57_TASKS, 1);
+	so_sched_use(previous);
+
+	so_sched_destroy(scheds[0]);
+	so_sched_destroy(scheds[1]);
+
+	for (i = 0; i < 2 * SO_TEST_57_TASKS; i++) {
+		if (test_exec_57_tids[i] == INVALID_TID)
+			so_fail("cannot fork an inline task");
+		for (j = i + 1; j < 2 * SO_TEST_57_TASKS; j++)
+			if (test_exec_57_tids[i] == test_exec_57_tids[j])
+				so_fail("inline id used twice");
+	}
+
+	test_exec_status = SO_TEST_SUCCESS;
+	basic_test(test_exec_status);
+}
+
+/*
+ * 58) Test auto-scaling
+ *
+ * tests if schedulers are added while there are many ready tasks, up to
+ * the maximum, and removed once they are no longer needed
+ */
+#define SO_TEST_58_TASKS	12
+#define SO_TEST_58_MAX		2
+#define SO_TEST_58_TRIES	10000
+
+static unsigned int test_exec_58_stop;
+
+static unsigned int test_exec_58_forked;
+
+static void test_sched_handler_58(void *arg)
+{
+	while (__sync_fetch_and_add(&test_exec_58_stop, 0) == 0)
+		so_exec();
+}
+
+static void test_sched_handler_58_master(void *arg)
+{
+	unsigned int i;
+
+	for (i = 0; i < SO_TEST_58_TASKS; i++)
+		so_fork_arg(test_sched_handler_58, NULL, 0);
+	__sync_fetch_and_add(&test_exec_58_forked, 1);
+}
+
+void test_sched_58(void)
+{
+	so_sched_t *scheds[SO_TEST_58_MAX], *previous;
+	unsigned int i, count = 1;
+
+	test_exec_status = SO_TEST_FAIL;
+	test_exec_58_stop = 0;
+	test_exec_58_forked = 0;
+
+	scheds[0] = so_sched_create(SO_MAX_UNITS, 0);
+	if (scheds[0] == NULL)
+		so_fail("cannot create a scheduler");
+	if (so_sched_autoscale(scheds, &count, 0) == 0)
+		so_fail("scaled past the maximum");
+
+	previous = so_sched_use(scheds[0]);
+	so_fork_arg(test_sched_handler_58_master, NULL, 1);
+	while (__sync_fetch_and_add(&test_exec_58_forked, 0) == 0)
+		sched_yield();
+
+	if (so_sched_autoscale(scheds, &count, SO_TEST_58_MAX) < 0 ||
+		count != 2)
+		so_fail("scheduler not added");
+	if (so_sched_ready_tasks(scheds[1]) == 0)
+		so_fail("new scheduler not balanced");
+	if (so_sched_autoscale(scheds, &count, SO_TEST_58_MAX) < 0 ||
+		count != SO_TEST_58_MAX)
+		so_fail("scheduler added past the maximum");
+
+	__sync_fetch_and_add(&test_exec_58_stop, 1);
+	for (i = 0; i < SO_TEST_58_TRIES && count > 1; i++) {
+		if (so_sched_autoscale(scheds, &count, SO_TEST_58_MAX) < 0)
+			so_fail("cannot scale down");
+		sched_yield();
+	}
+	if (count != 1)
+		so_fail("scheduler not removed");
+
+	so_sched_use(previous);
+	so_sched_destroy(scheds[0]);
+
+	test_exec_status = SO_TEST_SUCCESS;
+	basic_test(test_exec_status);
+}
+
+/*
+ * 59) Test signal order
+ *
+ * tests if the tasks woken by so_signal run in the order they started to
+ * wait in, with and without wake affine placement
+ */
+#define SO_TEST_59_WAITERS	4
+
+static tid_t test_exec_59_log[SO_TEST_59_WAITERS];
+static unsigned int test_exec_59_entries;
+
+static void test_sched_handler_59_waiter(unsigned int dummy)
+{
+	so_wait(0);
+	if (test_exec_59_entries < SO_TEST_59_WAITERS)
+		test_exec_59_log[test_exec_59_entries++] = so_self();
+}
+
+static void test_sched_handler_59_master(unsigned int dummy)
+{
+	tid_t tids[SO_TEST_59_WAITERS];
+	unsigned int i;
+	int affine;
+
+	for (affine = 0; affine <= 1; affine++) {
+		test_exec_59_entries = 0;
+
+		/* each waiter preempts me and blocks before so_fork returns */
+		for (i = 0; i < SO_TEST_59_WAITERS; i++)
+			tids[i] = so_fork(test_sched_handler_59_waiter, 2);
+
+		if (so_sched_set_wake_affine(affine) < 0)
+			so_fail("cannot set wake affine");
+		if (so_signal(0) != SO_TEST_59_WAITERS)
+			so_fail("waiters not woken");
+		so_wait_all(tids, SO_TEST_59_WAITERS);
+
+		if (test_exec_59_entries != SO_TEST_59_WAITERS)
+			so_fail("waiters did not run");
+		for (i = 0; i < SO_TEST_59_WAITERS; i++)
+			if (test_exec_59_log[i] != tids[i])
+				so_fail("waiters not run in order");
+	}
+
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_59(void)
+{
+	test_exec_status = SO_TEST_FAIL;
+
+	so_init(SO_MAX_UNITS, 1);
+
+	so_fork(test_sched_handler_59_master, 1);
+
+	sched_yield();
+	so_end();
+
+	basic_test(test_exec_status);
+}
+
+#undef SO_TEST_AND_SET
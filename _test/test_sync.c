@@ -0,0 +1,973 @@
+/*
+ * Threads scheduler synchronization tests
+ *
+ * 2017, Operating Systems
+ */
+
+#include "scheduler_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static unsigned int test_exec_status;
+
+/*
+ * 29) Test task mutex
+ *
+ * tests if a mutex is handed to the waiter and its owner inherits the
+ * priority of the waiter
+ */
+static so_task_mutex_t test_mutex_29;
+static unsigned int test_exec_29_med_runs;
+static unsigned int test_exec_29_high_runs;
+
+static void test_sched_handler_29_med(unsigned int priority)
+{
+	test_exec_29_med_runs++;
+}
+
+static void test_sched_handler_29_high(unsigned int priority)
+{
+	if (so_task_mutex_lock(&test_mutex_29) < 0)
+		so_fail("cannot lock mutex");
+
+	/* the medium priority task must not run while the owner has it */
+	if (test_exec_29_med_runs != 0)
+		so_fail("priority inversion");
+
+	if (so_task_mutex_unlock(&test_mutex_29) < 0)
+		so_fail("cannot unlock mutex");
+	test_exec_29_high_runs++;
+}
+
+static void test_sched_handler_29_low(unsigned int priority)
+{
+	unsigned int i;
+
+	if (so_task_mutex_lock(NULL) == 0 || so_task_mutex_unlock(NULL) == 0)
+		so_fail("missing mutex accepted");
+	if (so_task_mutex_unlock(&test_mutex_29) == 0)
+		so_fail("unlocked a mutex I do not hold");
+	if (so_task_mutex_lock(&test_mutex_29) < 0)
+		so_fail("cannot lock mutex");
+	if (so_task_mutex_lock(&test_mutex_29) == 0)
+		so_fail("locked the same mutex twice");
+
+	/* the high priority task waits for me and lends me its priority */
+	so_fork(test_sched_handler_29_high, 4);
+	so_fork(test_sched_handler_29_med, 2);
+	for (i = 0; i < SO_MAX_UNITS; i++)
+		so_exec();
+	if (test_exec_29_med_runs != 0 || test_exec_29_high_runs != 0)
+		so_fail("owner was preempted");
+
+	/* the mutex goes to the waiter and my priority drops back */
+	so_task_mutex_unlock(&test_mutex_29);
+	if (test_exec_29_high_runs != 1 || test_exec_29_med_runs != 1)
+		so_fail("owner kept the inherited priority");
+
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_29(void)
+{
+	test_exec_status = SO_TEST_FAIL;
+	test_exec_29_med_runs = 0;
+	test_exec_29_high_runs = 0;
+
+	so_init(1, 0);
+	so_task_mutex_init(&test_mutex_29);
+
+	so_fork(test_sched_handler_29_low, 1);
+
+	sched_yield();
+	so_end();
+	so_task_mutex_destroy(&test_mutex_29);
+	if (so_task_mutex_lock(&test_mutex_29) == 0)
+		test_exec_status = SO_TEST_FAIL;
+
+	basic_test(test_exec_status);
+}
+
+/*
+ * 30) Test task semaphore
+ *
+ * tests if the permits are handed to the waiters in priority order
+ */
+static so_task_sem_t test_sem_30;
+static unsigned int test_exec_30_order[2];
+static unsigned int test_exec_30_runs;
+
+static void test_sched_handler_30_waiter(unsigned int priority)
+{
+	if (so_task_sem_wait(&test_sem_30) < 0)
+		so_fail("cannot wait semaphore");
+	test_exec_30_order[test_exec_30_runs++] = priority;
+}
+
+static void test_sched_handler_30_master(unsigned int priority)
+{
+	/* a free permit is taken without waiting */
+	so_task_sem_post(&test_sem_30);
+	if (so_task_sem_wait(&test_sem_30) < 0)
+		so_fail("cannot wait semaphore");
+
+	so_fork(test_sched_handler_30_waiter, 2);
+	so_fork(test_sched_handler_30_waiter, 3);
+	if (test_exec_30_runs != 0)
+		so_fail("waiter did not wait");
+
+	so_task_sem_post(&test_sem_30);
+	if (test_exec_30_runs != 1 || test_exec_30_order[0] != 3)
+		so_fail("permit not given to the highest priority");
+	so_task_sem_post(&test_sem_30);
+	if (test_exec_30_runs != 2 || test_exec_30_order[1] != 2)
+		so_fail("permit not given to the waiter");
+
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_30(void)
+{
+	test_exec_status = SO_TEST_FAIL;
+	test_exec_30_runs = 0;
+
+	so_init(SO_MAX_UNITS, 0);
+	so_task_sem_init(&test_sem_30, 0);
+
+	so_fork(test_sched_handler_30_master, 1);
+
+	sched_yield();
+	so_end();
+	so_task_sem_destroy(&test_sem_30);
+
+	basic_test(test_exec_status);
+}
+
+/*
+ * 31) Test task barrier
+ *
+ * tests if the last task releases the others and the barrier is reusable
+ */
+static so_task_barrier_t test_barrier_31;
+static unsigned int test_exec_31_passed;
+static unsigned int test_exec_31_serial;
+
+static void test_sched_handler_31_worker(unsigned int priority)
+{
+	unsigned int round;
+	int ret;
+
+	for (round = 0; round < 2; round++) {
+		ret = so_task_barrier_wait(&test_barrier_31);
+		if (ret < 0)
+			so_fail("cannot wait barrier");
+		if (ret == SO_BARRIER_SERIAL)
+			test_exec_31_serial++;
+		test_exec_31_passed++;
+	}
+}
+
+static void test_sched_handler_31_master(unsigned int priority)
+{
+	so_fork(test_sched_handler_31_worker, 2);
+	so_fork(test_sched_handler_31_worker, 3);
+	if (test_exec_31_passed != 0)
+		so_fail("worker passed the barrier");
+
+	/* the workers run as soon as I arrive, as they rank higher */
+	if (so_task_barrier_wait(&test_barrier_31) != SO_BARRIER_SERIAL)
+		so_fail("last task is not serial");
+	if (test_exec_31_passed != 2)
+		so_fail("workers not released");
+
+	if (so_task_barrier_wait(&test_barrier_31) != SO_BARRIER_SERIAL)
+		so_fail("barrier not reusable");
+	if (test_exec_31_passed != 4 || test_exec_31_serial != 0)
+		so_fail("workers not released again");
+
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_31(void)
+{
+	test_exec_status = SO_TEST_FAIL;
+	test_exec_31_passed = 0;
+	test_exec_31_serial = 0;
+
+	so_init(SO_MAX_UNITS, 0);
+	if (so_task_barrier_init(&test_barrier_31, 0) == 0)
+		so_fail("barrier with no tasks");
+	so_task_barrier_init(&test_barrier_31, 3);
+
+	so_fork(test_sched_handler_31_master, 1);
+
+	sched_yield();
+	so_end();
+	so_task_barrier_destroy(&test_barrier_31);
+
+	basic_test(test_exec_status);
+}
+
+/*
+ * 32) Test task read-write lock
+ *
+ * tests if readers share the lock and a waiting writer with a higher
+ * priority goes before the readers that come after it
+ */
+static so_task_rwlock_t test_rwlock_32;
+static unsigned int test_exec_32_order[3];
+static unsigned int test_exec_32_runs;
+static unsigned int test_exec_32_intruded;
+
+static void test_sched_handler_32_reader(unsigned int priority)
+{
+	if (so_task_rwlock_rdlock(&test_rwlock_32) < 0)
+		so_fail("cannot lock for reading");
+	test_exec_32_order[test_exec_32_runs++] = priority;
+	if (so_task_rwlock_unlock(&test_rwlock_32) < 0)
+		so_fail("cannot unlock reader");
+}
+
+static void test_sched_handler_32_writer(unsigned int priority)
+{
+	if (so_task_rwlock_wrlock(&test_rwlock_32) < 0)
+		so_fail("cannot lock for writing");
+	test_exec_32_order[test_exec_32_runs++] = priority;
+	if (so_task_rwlock_unlock(&test_rwlock_32) < 0)
+		so_fail("cannot unlock writer");
+}
+
+static void test_sched_handler_32_intruder(unsigned int priority)
+{
+	if (so_task_rwlock_unlock(&test_rwlock_32) == 0)
+		so_fail("unlocked a rwlock read by another task");
+	test_exec_32_intruded = 1;
+}
+
+static void test_sched_handler_32_master(unsigned int priority)
+{
+	if (so_task_rwlock_unlock(&test_rwlock_32) == 0)
+		so_fail("unlocked a free rwlock");
+	if (so_task_rwlock_rdlock(&test_rwlock_32) < 0)
+		so_fail("cannot lock for reading");
+
+	/* readers share the lock */
+	so_fork(test_sched_handler_32_reader, 2);
+	if (test_exec_32_runs != 1)
+		so_fail("reader did not share the lock");
+
+	/* only the readers holding the lock may unlock it */
+	so_fork(test_sched_handler_32_intruder, 5);
+	if (test_exec_32_intruded != 1)
+		so_fail("intruder did not run");
+
+	/* the writer waits and keeps the next reader out */
+	so_fork(test_sched_handler_32_writer, 4);
+	so_fork(test_sched_handler_32_reader, 3);
+	if (test_exec_32_runs != 1)
+		so_fail("lock taken while held by a reader");
+
+	so_task_rwlock_unlock(&test_rwlock_32);
+	if (test_exec_32_runs != 3 || test_exec_32_order[1] != 4 ||
+		test_exec_32_order[2] != 3)
+		so_fail("writer did not go first");
+
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_32(void)
+{
+	test_exec_status = SO_TEST_FAIL;
+	test_exec_32_runs = 0;
+	test_exec_32_intruded = 0;
+
+	so_init(SO_MAX_UNITS, 0);
+	so_task_rwlock_init(&test_rwlock_32);
+
+	so_fork(test_sched_handler_32_master, 1);
+
+	sched_yield();
+	so_end();
+	so_task_rwlock_destroy(&test_rwlock_32);
+
+	basic_test(test_exec_status);
+}
+
+/*
+ * 33) Test task channel
+ *
+ * tests if a full channel parks the sender and the elements are received
+ * in the order they were sent
+ */
+#define TEST_33_ELEMS	8
+
+static so_task_chan_t test_chan_33;
+static unsigned int test_exec_33_received;
+
+static void test_sched_handler_33_consumer(unsigned int priority)
+{
+	unsigned int i, elem;
+
+	for (i = 0; i < TEST_33_ELEMS; i++) {
+		if (so_task_chan_recv(&test_chan_33, &elem) < 0)
+			so_fail("cannot receive");
+		if (elem != i)
+			so_fail("elements received out of order");
+		test_exec_33_received++;
+	}
+}
+
+static void test_sched_handler_33_producer(unsigned int priority)
+{
+	unsigned int i;
+
+	so_fork(test_sched_handler_33_consumer, 1);
+
+	/* the consumer runs only while I wait for free space */
+	for (i = 0; i < TEST_33_ELEMS; i++)
+		if (so_task_chan_send(&test_chan_33, &i) < 0)
+			so_fail("cannot send");
+	if (test_exec_33_received == 0)
+		so_fail("sender did not wait");
+	if (test_exec_33_received == TEST_33_ELEMS)
+		so_fail("consumer ran before me");
+
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_33(void)
+{
+	test_exec_status = SO_TEST_FAIL;
+	test_exec_33_received = 0;
+
+	so_init(SO_MAX_UNITS, 0);
+	if (so_task_chan_init(&test_chan_33, sizeof(unsigned int), 0) == 0)
+		so_fail("channel with no capacity");
+	so_task_chan_init(&test_chan_33, sizeof(unsigned int), 2);
+
+	so_fork(test_sched_handler_33_producer, 2);
+
+	sched_yield();
+	so_end();
+	if (test_exec_33_received != TEST_33_ELEMS)
+		so_fail("not all elements were received");
+	so_task_chan_destroy(&test_chan_33);
+
+	basic_test(test_exec_status);
+}
+
+/*
+ * 34) Test task channel batches
+ *
+ * tests if a batch larger than the channel is delivered in order to a
+ * receiver taking more than one element at a time
+ */
+#define TEST_34_ELEMS	10
+
+static so_task_chan_t test_chan_34;
+static unsigned int test_exec_34_received;
+static unsigned int test_exec_34_batches;
+
+static void test_sched_handler_34_consumer(unsigned int priority)
+{
+	unsigned int elems[TEST_34_ELEMS];
+	int i, ret;
+
+	while (test_exec_34_received < TEST_34_ELEMS) {
+		ret = so_task_chan_recv_many(&test_chan_34, elems,
+			TEST_34_ELEMS);
+		if (ret <= 0)
+			so_fail("cannot receive");
+		for (i = 0; i < ret; i++)
+			if (elems[i] != test_exec_34_received++)
+				so_fail("elements received out of order");
+		test_exec_34_batches++;
+	}
+}
+
+static void test_sched_handler_34_producer(unsigned int priority)
+{
+	unsigned int elems[TEST_34_ELEMS];
+	unsigned int i;
+
+	for (i = 0; i < TEST_34_ELEMS; i++)
+		elems[i] = i;
+
+	/* the consumer waits for the channel before I send */
+	so_fork(test_sched_handler_34_consumer, 2);
+	if (so_task_chan_send_many(&test_chan_34, elems, TEST_34_ELEMS) < 0)
+		so_fail("cannot send");
+	if (test_exec_34_received != TEST_34_ELEMS)
+		so_fail("not all elements were received");
+	if (test_exec_34_batches >= TEST_34_ELEMS)
+		so_fail("elements not received in batches");
+
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_34(void)
+{
+	test_exec_status = SO_TEST_FAIL;
+	test_exec_34_received = 0;
+	test_exec_34_batches = 0;
+
+	so_init(SO_MAX_UNITS, 0);
+	so_task_chan_init(&test_chan_34, sizeof(unsigned int), 4);
+
+	so_fork(test_sched_handler_34_producer, 1);
+
+	sched_yield();
+	so_end();
+	so_task_chan_destroy(&test_chan_34);
+
+	basic_test(test_exec_status);
+}
+
+/*
+ * 36) Test task graph
+ *
+ * tests if the tasks of a graph run after their dependencies and the ones
+ * on the critical path run first
+ */
+#define TEST_36_LAYERS	100
+#define TEST_36_WIDTH	10
+#define TEST_36_NODES	(TEST_36_LAYERS * TEST_36_WIDTH)
+
+static so_task_dag_node_t test_nodes_36[TEST_36_NODES];
+static so_task_dag_edge_t test_edges_36[2 * TEST_36_NODES];
+static unsigned int test_exec_36_done[TEST_36_NODES];
+static unsigned int test_exec_36_runs;
+
+static void test_sched_handler_36_node(void *arg)
+{
+	unsigned int index = (unsigned long) arg;
+	unsigned int i;
+
+	/* every task of the previous layer must have finished */
+	if (index >= TEST_36_WIDTH)
+		for (i = 0; i < TEST_36_WIDTH; i++)
+			if (!test_exec_36_done[index - index % TEST_36_WIDTH -
+				TEST_36_WIDTH + i])
+				so_fail("task ran before its dependencies");
+
+	test_exec_36_done[index] = ++test_exec_36_runs;
+	so_exec();
+}
+
+static void test_sched_handler_36_chain(void *arg)
+{
+	test_exec_36_done[(unsigned long) arg] = ++test_exec_36_runs;
+}
+
+static void test_sched_handler_36_master(unsigned int priority)
+{
+	unsigned int i, num_edges = 0;
+
+	/* each task depends on the next task of the previous layer too */
+	for (i = 0; i < TEST_36_NODES; i++) {
+		test_nodes_36[i].handler = test_sched_handler_36_node;
+		test_nodes_36[i].arg = (void *) (unsigned long) i;
+		test_nodes_36[i].priority = 1;
+		if (i < TEST_36_WIDTH)
+			continue;
+		test_edges_36[num_edges].from = i - TEST_36_WIDTH;
+		test_edges_36[num_edges++].to = i;
+	}
+	for (i = TEST_36_WIDTH; i < TEST_36_NODES; i++) {
+		test_edges_36[num_edges].from = i - i % TEST_36_WIDTH -
+			TEST_36_WIDTH + (i + 1) % TEST_36_WIDTH;
+		test_edges_36[num_edges++].to = i;
+	}
+
+	/* a missing task or a ring of dependencies must be refused */
+	test_edges_36[num_edges].from = TEST_36_NODES;
+	test_edges_36[num_edges].to = 0;
+	if (so_task_dag_run(test_nodes_36, TEST_36_NODES, test_edges_36,
+		num_edges + 1, 0) == 0)
+		so_fail("invalid edge accepted");
+	test_edges_36[num_edges].from = TEST_36_NODES - 1;
+	test_edges_36[num_edges].to = 0;
+	if (so_task_dag_run(test_nodes_36, TEST_36_NODES, test_edges_36,
+		num_edges + 1, 0) == 0)
+		so_fail("cycle accepted");
+	if (test_exec_36_runs != 0)
+		so_fail("task of an invalid graph ran");
+
+	/* each layer waits for all the tasks of the previous one */
+	if (so_task_dag_run(test_nodes_36, TEST_36_NODES, test_edges_36,
+		num_edges, 0) < 0)
+		so_fail("cannot run graph");
+	if (test_exec_36_runs != TEST_36_NODES)
+		so_fail("not all the tasks ran");
+
+	/* the start of a long chain goes before a lone task */
+	test_exec_36_runs = 0;
+	memset(test_exec_36_done, 0, sizeof(test_exec_36_done));
+	for (i = 0; i < 4; i++)
+		test_nodes_36[i].handler = test_sched_handler_36_chain;
+	test_edges_36[0].from = 1;
+	test_edges_36[0].to = 2;
+	test_edges_36[1].from = 2;
+	test_edges_36[1].to = 3;
+	if (so_task_dag_run(test_nodes_36, 4, test_edges_36, 2,
+		SO_TASK_DAG_CRITICAL_PATH) < 0)
+		so_fail("cannot run graph");
+	if (test_exec_36_done[1] != 1 || test_exec_36_done[0] == 1)
+		so_fail("critical path did not run first");
+
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_36(void)
+{
+	test_exec_status = SO_TEST_FAIL;
+	test_exec_36_runs = 0;
+
+	so_init(SO_MAX_UNITS, 0);
+
+	so_fork(test_sched_handler_36_master, 1);
+
+	sched_yield();
+	so_end();
+
+	basic_test(test_exec_status);
+}
+
+/*
+ * 37) Test parallel loop
+ *
+ * tests if a loop of a million indexes is run once for each index by a few
+ * tasks
+ */
+#define TEST_37_BEGIN	10
+#define TEST_37_END	1000010
+#define TEST_37_GRAIN	999
+#define TEST_37_HOSTS	16
+
+static unsigned char test_exec_37_visited[TEST_37_END];
+static tid_t test_hosts_37[TEST_37_HOSTS];
+static unsigned int test_exec_37_hosts;
+static unsigned long test_exec_37_chunks;
+
+static void test_sched_handler_37_chunk(unsigned long begin,
+	unsigned long end, void *arg)
+{
+	unsigned int i;
+
+	if (arg != &test_exec_37_chunks)
+		so_fail("wrong argument");
+	if (end - begin > TEST_37_GRAIN)
+		so_fail("chunk larger than the grain");
+	for (; begin < end; begin++)
+		test_exec_37_visited[begin]++;
+	test_exec_37_chunks++;
+
+	for (i = 0; i < test_exec_37_hosts; i++)
+		if (equal_tids(test_hosts_37[i], get_tid()))
+			return;
+	if (test_exec_37_hosts == TEST_37_HOSTS)
+		so_fail("too many threads");
+	test_hosts_37[test_exec_37_hosts++] = get_tid();
+}
+
+static void test_sched_handler_37_master(unsigned int priority)
+{
+	unsigned long i;
+
+	if (so_parallel_for(0, 1, 0, test_sched_handler_37_chunk, NULL) == 0)
+		so_fail("loop with no grain");
+	if (so_parallel_for(TEST_37_BEGIN, TEST_37_END, TEST_37_GRAIN,
+		test_sched_handler_37_chunk, &test_exec_37_chunks) < 0)
+		so_fail("cannot run loop");
+
+	if (test_exec_37_chunks != (TEST_37_END - TEST_37_BEGIN +
+		TEST_37_GRAIN - 1) / TEST_37_GRAIN)
+		so_fail("wrong number of chunks");
+	for (i = 0; i < TEST_37_END; i++)
+		if (test_exec_37_visited[i] != (i >= TEST_37_BEGIN))
+			so_fail("index not visited once");
+
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_37(void)
+{
+	test_exec_status = SO_TEST_FAIL;
+	test_exec_37_hosts = 0;
+	test_exec_37_chunks = 0;
+
+	so_init(get_rand(1, SO_MAX_UNITS), 0);
+
+	so_fork(test_sched_handler_37_master, 1);
+
+	sched_yield();
+	so_end();
+
+	basic_test(test_exec_status);
+}
+
+/*
+ * 51) Test kill in sync objects
+ *
+ * tests if a task cancelled while it waits at a barrier or holds or waits
+ * for a read-write lock leaves the object usable, if the permits it took
+ * from a semaphore are not given back, unless a post handed one to it and
+ * it did not run again, and if joining it reports the cancellation
+ */
+static so_task_barrier_t test_barrier_51;
+static so_task_rwlock_t test_rwlock_51;
+static so_task_sem_t test_sem_51;
+static unsigned int test_exec_51_passed;
+static unsigned int test_exec_51_readers;
+static unsigned int test_exec_51_consumed;
+
+static void test_sched_handler_51_barrier(unsigned int priority)
+{
+	so_task_barrier_wait(&test_barrier_51);
+	test_exec_51_passed++;
+}
+
+static void test_sched_handler_51_holder(unsigned int priority)
+{
+	so_task_rwlock_rdlock(&test_rwlock_51);
+	so_task_sem_wait(&test_sem_51);
+	so_wait(0);
+	so_fail("cancelled task was woken");
+}
+
+static void test_sched_handler_51_consumer(unsigned int priority)
+{
+	so_task_sem_wait(&test_sem_51);
+	test_exec_51_consumed++;
+}
+
+static void test_sched_handler_51_writer(unsigned int priority)
+{
+	so_task_rwlock_wrlock(&test_rwlock_51);
+	so_fail("cancelled writer got the lock");
+}
+
+static void test_sched_handler_51_reader(unsigned int priority)
+{
+	so_task_rwlock_rdlock(&test_rwlock_51);
+	test_exec_51_readers++;
+	so_task_rwlock_unlock(&test_rwlock_51);
+}
+
+static void test_sched_handler_51_master(unsigned int priority)
+{
+	tid_t tid;
+
+	/* a cancelled waiter no longer counts as arrived at the barrier */
+	tid = so_fork(test_sched_handler_51_barrier, 2);
+	so_kill(tid);
+	if (so_join(tid) != SO_JOIN_CANCELLED)
+		so_fail("join did not report the cancellation");
+	tid = so_fork(test_sched_handler_51_barrier, 2);
+	if (test_exec_51_passed != 0)
+		so_fail("barrier opened too early");
+	if (so_task_barrier_wait(&test_barrier_51) != SO_BARRIER_SERIAL)
+		so_fail("barrier kept the cancelled waiter");
+	if (test_exec_51_passed != 1)
+		so_fail("waiter not released");
+	if (so_join(tid) != 0)
+		so_fail("join reported a cancellation");
+
+	/* the read lock of a cancelled task is released, its permit is not */
+	so_task_sem_post(&test_sem_51);
+	tid = so_fork(test_sched_handler_51_holder, 2);
+	so_kill(tid);
+	if (so_task_rwlock_wrlock(&test_rwlock_51) < 0 ||
+		so_task_rwlock_unlock(&test_rwlock_51) < 0)
+		so_fail("read lock of the cancelled task kept");
+	so_fork(test_sched_handler_51_consumer, 3);
+	if (test_exec_51_consumed != 0)
+		so_fail("permit of the cancelled task given back");
+	so_task_sem_post(&test_sem_51);
+	if (test_exec_51_consumed != 1)
+		so_fail("waiter not given the permit");
+
+	/* a permit handed to a task cancelled before running is passed on */
+	tid = so_fork(test_sched_handler_51_consumer, 3);
+	so_set_priority(tid, 0);
+	so_task_sem_post(&test_sem_51);
+	so_kill(tid);
+	so_fork(test_sched_handler_51_consumer, 3);
+	if (test_exec_51_consumed != 2)
+		so_fail("permit handed to the cancelled task lost");
+
+	/* a cancelled waiting writer lets in the readers behind it */
+	so_task_rwlock_rdlock(&test_rwlock_51);
+	tid = so_fork(test_sched_handler_51_writer, 3);
+	so_fork(test_sched_handler_51_reader, 2);
+	if (test_exec_51_readers != 0)
+		so_fail("reader went before the writer");
+	so_kill(tid);
+	if (test_exec_51_readers != 1)
+		so_fail("reader kept out by the cancelled writer");
+	so_task_rwlock_unlock(&test_rwlock_51);
+
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_51(void)
+{
+	test_exec_status = SO_TEST_FAIL;
+	test_exec_51_passed = 0;
+	test_exec_51_readers = 0;
+	test_exec_51_consumed = 0;
+
+	so_init(SO_MAX_UNITS, 1);
+	so_task_barrier_init(&test_barrier_51, 2);
+	so_task_rwlock_init(&test_rwlock_51);
+	so_task_sem_init(&test_sem_51, 0);
+
+	so_fork(test_sched_handler_51_master, 1);
+
+	sched_yield();
+	so_end();
+	so_task_barrier_destroy(&test_barrier_51);
+	so_task_rwlock_destroy(&test_rwlock_51);
+	so_task_sem_destroy(&test_sem_51);
+
+	basic_test(test_exec_status);
+}
+
+/*
+ * 53) Test sync objects of a scheduler
+ *
+ * tests if the sync objects used by the tasks of a scheduler refuse the
+ * tasks of another scheduler instead of waking its tasks
+ */
+static so_task_mutex_t test_mutex_53;
+static so_task_sem_t test_sem_53;
+static unsigned int test_exec_53_refused;
+static unsigned int test_exec_53_woken;
+static unsigned int test_exec_53_used;
+
+static void test_sched_handler_53_waiter(unsigned int priority)
+{
+	so_task_mutex_lock(&test_mutex_53);
+	so_task_mutex_unlock(&test_mutex_53);
+	so_task_sem_post(&test_sem_53);
+	so_task_sem_wait(&test_sem_53);
+	__sync_fetch_and_add(&test_exec_53_used, 1);
+
+	so_task_sem_wait(&test_sem_53);
+	test_exec_53_woken++;
+}
+
+static void test_sched_handler_53_other(unsigned int priority)
+{
+	if (so_task_mutex_lock(&test_mutex_53) < 0)
+		test_exec_53_refused++;
+	if (so_task_sem_post(&test_sem_53) < 0)
+		test_exec_53_refused++;
+}
+
+static void test_sched_handler_53_poster(unsigned int priority)
+{
+	so_task_sem_post(&test_sem_53);
+}
+
+void test_sched_53(void)
+{
+	so_sched_t *other, *previous;
+
+	test_exec_status = SO_TEST_FAIL;
+	test_exec_53_refused = 0;
+	test_exec_53_woken = 0;
+	test_exec_53_used = 0;
+
+	so_init(SO_MAX_UNITS, 0);
+	so_task_mutex_init(&test_mutex_53);
+	so_task_sem_init(&test_sem_53, 0);
+	other = so_sched_create(SO_MAX_UNITS, 0);
+	if (other == NULL)
+		so_fail("cannot create a scheduler");
+
+	/* the objects belong to the default scheduler once its task used them */
+	so_fork(test_sched_handler_53_waiter, 1);
+	while (__sync_fetch_and_add(&test_exec_53_used, 0) == 0)
+		sched_yield();
+
+	previous = so_sched_use(other);
+	so_fork(test_sched_handler_53_other, 1);
+	so_sched_destroy(other);
+	so_sched_use(previous);
+
+	if (test_exec_53_refused == 2 && test_exec_53_woken == 0)
+		test_exec_status = SO_TEST_SUCCESS;
+
+	so_fork(test_sched_handler_53_poster, 1);
+	so_end();
+	so_task_mutex_destroy(&test_mutex_53);
+	so_task_sem_destroy(&test_sem_53);
+
+	if (test_exec_53_woken != 1)
+		test_exec_status = SO_TEST_FAIL;
+
+	basic_test(test_exec_status);
+}
+
+/*
+ * 54) Test kill in a task graph
+ *
+ * tests if the tasks depending on a cancelled task of a graph are skipped
+ * and running the graph reports the cancellation instead of hanging
+ */
+#define TEST_54_NODES	4
+
+static so_task_dag_node_t test_nodes_54[TEST_54_NODES];
+static so_task_dag_edge_t test_edges_54[2];
+static unsigned int test_exec_54_ran[TEST_54_NODES];
+
+static void test_sched_handler_54_node(void *arg)
+{
+	unsigned int index = (unsigned long) arg;
+
+	test_exec_54_ran[index]++;
+	if (index == 1)
+		so_kill(so_self());
+	so_exec();
+}
+
+static void test_sched_handler_54_master(unsigned int priority)
+{
+	unsigned int i;
+
+	/* 0 -> 1 -> 2, while 3 depends on nothing */
+	for (i = 0; i < TEST_54_NODES; i++) {
+		test_nodes_54[i].handler = test_sched_handler_54_node;
+		test_nodes_54[i].arg = (void *) (unsigned long) i;
+		test_nodes_54[i].priority = 2;
+	}
+	test_edges_54[0].from = 0;
+	test_edges_54[0].to = 1;
+	test_edges_54[1].from = 1;
+	test_edges_54[1].to = 2;
+
+	if (so_task_dag_run(test_nodes_54, TEST_54_NODES, test_edges_54, 2,
+		0) >= 0)
+		so_fail("cancelled task not reported");
+	if (test_exec_54_ran[0] != 1 || test_exec_54_ran[1] != 1 ||
+		test_exec_54_ran[3] != 1)
+		so_fail("task of the graph did not run");
+	if (test_exec_54_ran[2] != 0)
+		so_fail("dependant of the cancelled task ran");
+
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_54(void)
+{
+	test_exec_status = SO_TEST_FAIL;
+	memset(test_exec_54_ran, 0, sizeof(test_exec_54_ran));
+
+	so_init(SO_MAX_UNITS, 0);
+	so_fork(test_sched_handler_54_master, 1);
+
+	sched_yield();
+	so_end();
+
+	basic_test(test_exec_status);
+}
+
+/*
+ * 56) Test task mutex across groups
+ *
+ * tests if the owner of a mutex inherits the priority of a waiter from
+ * another group and gets ahead of the other tasks of its own group
+ */
+static so_task_mutex_t test_mutex_56;
+static so_task_group_t *test_group_56_waiter;
+static unsigned int test_exec_56_waiting;
+static unsigned int test_exec_56_high_runs;
+static unsigned int test_exec_56_med_runs;
+
+static tid_t test_fork_56(so_arg_handler *func, unsigned int priority,
+	so_task_group_t *group)
+{
+	so_task_attr_t attr;
+
+	so_task_attr_init(&attr);
+	attr.priority = priority;
+	attr.group = group;
+	return so_fork_attr(func, NULL, &attr);
+}
+
+static void test_sched_handler_56_med(void *arg)
+{
+	test_exec_56_med_runs++;
+}
+
+static void test_sched_handler_56_high(void *arg)
+{
+	test_exec_56_waiting = 1;
+	if (so_task_mutex_lock(&test_mutex_56) < 0)
+		so_fail("cannot lock mutex");
+	test_exec_56_high_runs++;
+	so_task_mutex_unlock(&test_mutex_56);
+}
+
+static void test_sched_handler_56_low(void *arg)
+{
+	unsigned int i;
+
+	if (so_task_mutex_lock(&test_mutex_56) < 0)
+		so_fail("cannot lock mutex");
+
+	/* the waiter runs in the turns of its own group */
+	test_fork_56(test_sched_handler_56_high, 4, test_group_56_waiter);
+	while (test_exec_56_waiting == 0)
+		so_exec();
+
+	/* the task forked in my group does not preempt me */
+	test_fork_56(test_sched_handler_56_med, 3, NULL);
+	for (i = 0; i < 4 * SO_MAX_UNITS; i++)
+		so_exec();
+	if (test_exec_56_med_runs != 0 || test_exec_56_high_runs != 0)
+		so_fail("owner was preempted in its group");
+
+	so_task_mutex_unlock(&test_mutex_56);
+}
+
+static void test_sched_handler_56_master(unsigned int priority)
+{
+	so_task_group_t *owner_group;
+	tid_t tid;
+
+	owner_group = so_task_group_create(NULL, SO_GROUP_DEFAULT_WEIGHT);
+	test_group_56_waiter = so_task_group_create(NULL,
+			SO_GROUP_DEFAULT_WEIGHT);
+	if (owner_group == NULL || test_group_56_waiter == NULL)
+		so_fail("cannot create groups");
+
+	tid = test_fork_56(test_sched_handler_56_low, 1, owner_group);
+	so_join(tid);
+	while (test_exec_56_high_runs == 0 || test_exec_56_med_runs == 0)
+		so_exec();
+
+	test_exec_status = SO_TEST_SUCCESS;
+}
+
+void test_sched_56(void)
+{
+	test_exec_status = SO_TEST_FAIL;
+	test_exec_56_waiting = 0;
+	test_exec_56_high_runs = 0;
+	test_exec_56_med_runs = 0;
+
+	so_init(1, 0);
+	so_task_mutex_init(&test_mutex_56);
+
+	so_fork(test_sched_handler_56_master, 1);
+
+	sched_yield();
+	so_end();
+	so_task_mutex_destroy(&test_mutex_56);
+
+	basic_test(test_exec_status);
+}
@@ -27,6 +27,7 @@ priority_queue_t *priority_queue_init(size_t data_size, comparator_t comp, copy_
 		vector_copy_function(v, copy);
 	pq->container = v;
 	pq->comp = comp;
+	pq->set_index = NULL;
 	return pq;
 }
 
@@ -46,16 +47,36 @@ int priority_queue_empty(priority_queue_t *pq)
 	return vector_empty(pq->container);
 }
 
-/* swaps two elements from the pq */
-static void swap(void *a, void *b, int data_size,
-			void (*move_elem)(void *, void *, size_t))
+/* notifies the new position of the element at given index */
+static void update_index(priority_queue_t *pq, size_t index)
 {
-	void *tmp = malloc(data_size);
+	if (pq->set_index != NULL)
+		pq->set_index(vector_get(pq->container, index), index);
+}
+
+/* swaps two elements from the pq, small elements are swapped on stack */
+static void swap(priority_queue_t *pq, size_t first, size_t second)
+{
+	vector_t *v = pq->container;
+	void *a = vector_get(v, first);
+	void *b = vector_get(v, second);
+	char buffer[SWAP_BUFFER_SIZE];
+	void *tmp = buffer;
+
+	if (v->data_size > SWAP_BUFFER_SIZE) {
+		tmp = malloc(v->data_size);
+		if (!tmp)
+			return;
+	}
 
-	move_elem(tmp, a, data_size);
-	move_elem(a, b, data_size);
-	move_elem(b, tmp, data_size);
-	free(tmp);
+	v->copy_element(tmp, a, v->data_size);
+	v->copy_element(a, b, v->data_size);
+	v->copy_element(b, tmp, v->data_size);
+	if (tmp != buffer)
+		free(tmp);
+
+	update_index(pq, first);
+	update_index(pq, second);
 }
 
 /* reestablish the heap order after push */
@@ -75,9 +96,9 @@ static void heapify_up(priority_queue_t *pq, size_t index)
 		void *parent = vector_get(v, PARENT(index));
 		void *current = vector_get(v, index);
 
-		if (comp(parent, current) >= 0)
-			swap(parent, current,
-				v->data_size, pq->container->copy_element);
+		if (comp(parent, current) < 0)
+			break;
+		swap(pq, PARENT(index), index);
 		index = PARENT(index);
 	}
 }
@@ -88,36 +109,31 @@ static void heapify_down(priority_queue_t *pq, size_t index)
 	vector_t *v;
 	comparator_t comp;
 	size_t left_son, right_son, min_son;
-	void *current, *left, *right;
-
-	v = pq->container;
-	comp = pq->comp;
 
 	if (!pq || !pq->comp)
 		return;
 
+	v = pq->container;
+	comp = pq->comp;
+
 	while (index < vector_size(v)) {
 		min_son = index;
 		left_son = LEFT_SON(index);
 		right_son = RIGHT_SON(index);
-		current = vector_get(v, index);
 
-		if (left_son < vector_size(v)) {
-			left = vector_get(v, left_son);
-			if (comp(left, current) <= 0)
-				min_son = left_son;
-		}
+		if (left_son < vector_size(v) &&
+			comp(vector_get(v, left_son),
+				vector_get(v, min_son)) <= 0)
+			min_son = left_son;
 
-		if (right_son < vector_size(v)) {
-			right = vector_get(v, right_son);
-			if (comp(right, left) <= 0)
-				min_son = right_son;
-		}
+		if (right_son < vector_size(v) &&
+			comp(vector_get(v, right_son),
+				vector_get(v, min_son)) <= 0)
+			min_son = right_son;
 
 		if (min_son == index)
 			break;
-		swap(current, vector_get(v, min_son),
-					v->data_size, v->copy_element);
+		swap(pq, index, min_son);
 		index = min_son;
 	}
 }
@@ -128,6 +144,7 @@ void priority_queue_push(priority_queue_t *pq, void *data)
 	if (!pq || !data)
 		return;
 	vector_push_back(pq->container, data);
+	update_index(pq, vector_size(pq->container) - 1);
 	heapify_up(pq, vector_size(pq->container) - 1);
 
 }
@@ -144,8 +161,7 @@ void priority_queue_pop(priority_queue_t *pq)
 	v = pq->container;
 
 	if (priority_queue_size(pq) > 1)
-		swap(vector_get_front(v), vector_get_back(v),
-				v->data_size, v->copy_element);
+		swap(pq, 0, vector_size(v) - 1);
 
 	vector_pop_back(pq->container);
 	if (priority_queue_size(pq) > 1)
@@ -160,6 +176,47 @@ void *priority_queue_top(priority_queue_t *pq)
 	return vector_get_front(pq->container);
 }
 
+/* get the element at given index */
+void *priority_queue_get(priority_queue_t *pq, size_t index)
+{
+	if (!pq || index >= priority_queue_size(pq))
+		return NULL;
+	return vector_get(pq->container, index);
+}
+
+/* restore the heap order after the key at given index has changed */
+void priority_queue_update(priority_queue_t *pq, size_t index)
+{
+	if (!pq || index >= priority_queue_size(pq))
+		return;
+
+	heapify_up(pq, index);
+	heapify_down(pq, index);
+}
+
+/* removes the element at given index from the priority queue */
+void priority_queue_remove(priority_queue_t *pq, size_t index)
+{
+	size_t last;
+
+	if (!pq || index >= priority_queue_size(pq))
+		return;
+
+	last = vector_size(pq->container) - 1;
+	if (index != last)
+		swap(pq, index, last);
+
+	vector_pop_back(pq->container);
+	if (index != last)
+		priority_queue_update(pq, index);
+}
+
+/* change the function used to track the position of the elements */
+void priority_queue_index_function(priority_queue_t *pq, index_t set_index)
+{
+	pq->set_index = set_index;
+}
+
 /* free the resources allocated for the pq */
 void priority_queue_free(priority_queue_t *pq)
 {
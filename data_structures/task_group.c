@@ -0,0 +1,177 @@
+/* Copyright Radu Nichita radunichita99@gmail.com */
+#include <stdlib.h>
+
+#include "task_group.h"
+
+#define STRIDE(weight) (TASK_GROUP_STRIDE / (weight))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+
+/* initialize a group */
+task_group_t *task_group_init(task_group_t *parent, unsigned int weight,
+				priority_queue_t *ready)
+{
+	task_group_t *g;
+
+	if (!ready || weight == 0 || weight > TASK_GROUP_MAX_WEIGHT)
+		return NULL;
+
+	g = calloc(1, sizeof(task_group_t));
+	if (!g)
+		return NULL;
+
+	g->parent = parent;
+	g->weight = weight;
+	g->ready = ready;
+
+	/* start from the virtual time of the siblings, not from 0 */
+	if (parent) {
+		g->pass = parent->vtime;
+		g->next_sibling = parent->children;
+		parent->children = g;
+	}
+	return g;
+}
+
+/* add a ready task in a group */
+void task_group_push(task_group_t *g, void *data)
+{
+	if (!g || !data)
+		return;
+
+	if (priority_queue_empty(g->ready))
+		g->own_pass = MAX(g->own_pass, g->vtime);
+	priority_queue_push(g->ready, data);
+
+	/* the groups becoming ready catch up with their siblings */
+	for (; g; g = g->parent) {
+		if (g->nr_ready++ == 0 && g->parent)
+			g->pass = MAX(g->pass, g->parent->vtime);
+	}
+}
+
+/* remove a ready task from a group */
+void task_group_remove(task_group_t *g, size_t index)
+{
+	if (!g || index >= priority_queue_size(g->ready))
+		return;
+
+	priority_queue_remove(g->ready, index);
+	for (; g; g = g->parent)
+		g->nr_ready--;
+}
+
+/* update the period of the quota of a group to the current one */
+static void update_period(task_group_t *g, unsigned long clock)
+{
+	if (g->quota == 0 || g->period_index == clock / g->period)
+		return;
+
+	g->period_index = clock / g->period;
+	g->used = 0;
+}
+
+/* check if a group or one of its ancestors has run its quota */
+int task_group_throttled(task_group_t *g, unsigned long clock)
+{
+	for (; g; g = g->parent) {
+		update_period(g, clock);
+		if (g->quota != 0 && g->used >= g->quota)
+			return 1;
+	}
+	return 0;
+}
+
+/** go down from the root choosing the subgroup or the own tasks with the
+ * smallest pass
+ * @return the group or NULL if all the ready tasks are throttled
+ */
+static task_group_t *pick(task_group_t *g, unsigned long clock,
+				int skip_throttled)
+{
+	task_group_t *child, *best;
+
+	while (g) {
+		best = NULL;
+		for (child = g->children; child; child = child->next_sibling) {
+			if (child->nr_ready == 0)
+				continue;
+			if (skip_throttled) {
+				update_period(child, clock);
+				if (child->quota != 0 &&
+					child->used >= child->quota)
+					continue;
+			}
+			if (!best || child->pass < best->pass)
+				best = child;
+		}
+
+		if (!priority_queue_empty(g->ready) &&
+			(!best || g->own_pass <= best->pass))
+			return g;
+		g = best;
+	}
+	return NULL;
+}
+
+/* choose the group whose first ready task should run next */
+task_group_t *task_group_pick(task_group_t *root, unsigned long clock)
+{
+	task_group_t *g;
+
+	if (!root || root->nr_ready == 0)
+		return NULL;
+
+	/* time passes only while tasks run, so never leave the cpu idle */
+	g = pick(root, clock, 1);
+	if (!g)
+		g = pick(root, clock, 0);
+	return g;
+}
+
+/* account a unit run by a task of a group */
+void task_group_charge(task_group_t *g, unsigned long clock)
+{
+	if (!g)
+		return;
+
+	g->vtime = g->own_pass;
+	g->own_pass += STRIDE(TASK_GROUP_DEFAULT_WEIGHT);
+	for (; g; g = g->parent) {
+		update_period(g, clock);
+		g->used++;
+		if (g->parent) {
+			g->parent->vtime = g->pass;
+			g->pass += STRIDE(g->weight);
+		}
+	}
+}
+
+/* remove a group from its parent and free it */
+void task_group_free(task_group_t *g)
+{
+	task_group_t **link;
+
+	if (!g)
+		return;
+
+	if (g->parent) {
+		link = &g->parent->children;
+		while (*link != g)
+			link = &(*link)->next_sibling;
+		*link = g->next_sibling;
+	}
+
+	priority_queue_free(g->ready);
+	free(g);
+}
+
+/* free a group with all its subgroups */
+void task_group_free_all(task_group_t *g)
+{
+	if (!g)
+		return;
+
+	while (g->children)
+		task_group_free_all(g->children);
+	task_group_free(g);
+}
@@ -0,0 +1,236 @@
+/* Copyright Radu Nichita radunichita99@gmail.com */
+#include <stdlib.h>
+#include <string.h>
+
+#include "task_table.h"
+
+#define HANDLE_INDEX(handle) ((handle) & TASK_TABLE_INDEX_MASK)
+#define HANDLE_GENERATION(handle) ((handle) >> TASK_TABLE_INDEX_BITS)
+#define MAKE_HANDLE(generation, index) \
+	(((generation) << TASK_TABLE_INDEX_BITS) | (index))
+#define MAX_GENERATION (~0u >> TASK_TABLE_INDEX_BITS)
+
+/* mix the bits of a key, since thread ids are usually aligned addresses */
+static size_t hash_key(unsigned long key)
+{
+	key ^= key >> 16;
+	key *= 0x45d9f3bUL;
+	key ^= key >> 16;
+	return (size_t) key;
+}
+
+/* initialize a task table */
+task_table_t *task_table_init(void)
+{
+	task_table_t *t;
+
+	t = malloc(sizeof(task_table_t));
+	if (!t)
+		return NULL;
+
+	t->slots = vector_init(sizeof(task_slot_t));
+	t->free_slots = vector_init(sizeof(size_t));
+	t->buckets = calloc(TASK_TABLE_INITIAL_BUCKETS, sizeof(size_t));
+	if (!t->slots || !t->free_slots || !t->buckets) {
+		if (t->slots)
+			free_vector(t->slots);
+		if (t->free_slots)
+			free_vector(t->free_slots);
+		free(t->buckets);
+		free(t);
+		return NULL;
+	}
+
+	t->num_buckets = TASK_TABLE_INITIAL_BUCKETS;
+	t->size = 0;
+	return t;
+}
+
+/* get the slot found at given index */
+static task_slot_t *get_slot(task_table_t *t, size_t index)
+{
+	return (task_slot_t *) vector_get(t->slots, index);
+}
+
+/* get the bucket that refers the given key or the empty one ending probe */
+static size_t find_bucket(task_table_t *t, size_t *buckets,
+				size_t num_buckets, unsigned long key)
+{
+	size_t mask = num_buckets - 1;
+	size_t bucket = hash_key(key) & mask;
+
+	while (buckets[bucket] != 0 &&
+		get_slot(t, buckets[bucket] - 1)->key != key)
+		bucket = (bucket + 1) & mask;
+
+	return bucket;
+}
+
+/* double the number of buckets and rehash the keys */
+static int grow_buckets(task_table_t *t)
+{
+	size_t *buckets;
+	size_t num_buckets, i, bucket;
+
+	num_buckets = t->num_buckets * 2;
+	buckets = calloc(num_buckets, sizeof(size_t));
+	if (!buckets)
+		return -1;
+
+	for (i = 0; i < t->num_buckets; ++i) {
+		if (t->buckets[i] == 0)
+			continue;
+		bucket = find_bucket(t, buckets, num_buckets,
+				get_slot(t, t->buckets[i] - 1)->key);
+		buckets[bucket] = t->buckets[i];
+	}
+
+	free(t->buckets);
+	t->buckets = buckets;
+	t->num_buckets = num_buckets;
+	return 0;
+}
+
+/* add an entry in the table and index it by its key */
+task_handle_t task_table_insert(task_table_t *t, unsigned long key,
+				void *value)
+{
+	task_slot_t new_slot, *slot;
+	size_t index, bucket;
+
+	if (!t)
+		return INVALID_HANDLE;
+
+	if (t->size + 1 > t->num_buckets * TASK_TABLE_LOAD_FACTOR &&
+		grow_buckets(t) < 0)
+		return INVALID_HANDLE;
+
+	/* reuse a free slot if there is one, otherwise add a new one */
+	if (!vector_empty(t->free_slots)) {
+		index = *(size_t *) vector_get_back(t->free_slots);
+		vector_pop_back(t->free_slots);
+	} else {
+		index = vector_size(t->slots);
+		if (index >= TASK_TABLE_MAX_SLOTS)
+			return INVALID_HANDLE;
+		memset(&new_slot, 0, sizeof(new_slot));
+		if (vector_push_back(t->slots, &new_slot) < 0)
+			return INVALID_HANDLE;
+	}
+
+	slot = get_slot(t, index);
+	slot->key = key;
+	slot->value = value;
+	slot->used = 1;
+	if (++slot->generation > MAX_GENERATION)
+		slot->generation = 1;
+
+	/* an existing key is shadowed by the new entry */
+	bucket = find_bucket(t, t->buckets, t->num_buckets, key);
+	t->buckets[bucket] = index + 1;
+	t->size++;
+
+	return MAKE_HANDLE(slot->generation, (unsigned int) index);
+}
+
+/* get the slot refered by a handle or NULL if the handle is stale */
+static task_slot_t *handle_slot(task_table_t *t, task_handle_t handle)
+{
+	task_slot_t *slot;
+
+	if (!t || HANDLE_INDEX(handle) >= vector_size(t->slots))
+		return NULL;
+
+	slot = get_slot(t, HANDLE_INDEX(handle));
+	if (!slot->used || slot->generation != HANDLE_GENERATION(handle))
+		return NULL;
+	return slot;
+}
+
+/* get the value stored by handle */
+void *task_table_get(task_table_t *t, task_handle_t handle)
+{
+	task_slot_t *slot = handle_slot(t, handle);
+
+	if (!slot)
+		return NULL;
+	return slot->value;
+}
+
+/* get the handle of an entry by its key */
+task_handle_t task_table_find(task_table_t *t, unsigned long key)
+{
+	task_slot_t *slot;
+	size_t bucket;
+
+	if (!t)
+		return INVALID_HANDLE;
+
+	bucket = find_bucket(t, t->buckets, t->num_buckets, key);
+	if (t->buckets[bucket] == 0)
+		return INVALID_HANDLE;
+
+	slot = get_slot(t, t->buckets[bucket] - 1);
+	return MAKE_HANDLE(slot->generation,
+			(unsigned int) (t->buckets[bucket] - 1));
+}
+
+/* remove a bucket, shifting back the following ones of the same probe */
+static void remove_bucket(task_table_t *t, size_t bucket)
+{
+	size_t mask = t->num_buckets - 1;
+	size_t next, home;
+
+	next = (bucket + 1) & mask;
+	while (t->buckets[next] != 0) {
+		home = hash_key(get_slot(t, t->buckets[next] - 1)->key) & mask;
+
+		/* move the entry back if its home is not in (bucket, next] */
+		if (((next - home) & mask) >= ((next - bucket) & mask)) {
+			t->buckets[bucket] = t->buckets[next];
+			bucket = next;
+		}
+		next = (next + 1) & mask;
+	}
+	t->buckets[bucket] = 0;
+}
+
+/* remove an entry from the table */
+void task_table_remove(task_table_t *t, task_handle_t handle)
+{
+	task_slot_t *slot = handle_slot(t, handle);
+	size_t index, bucket;
+
+	if (!slot)
+		return;
+
+	/* the key may already refer a newer entry */
+	index = HANDLE_INDEX(handle);
+	bucket = find_bucket(t, t->buckets, t->num_buckets, slot->key);
+	if (t->buckets[bucket] == index + 1)
+		remove_bucket(t, bucket);
+
+	slot->used = 0;
+	slot->value = NULL;
+	vector_push_back(t->free_slots, &index);
+	t->size--;
+}
+
+/* return the number of entries */
+size_t task_table_size(task_table_t *t)
+{
+	if (!t)
+		return 0;
+	return t->size;
+}
+
+/* free the resources allocated for the task table */
+void task_table_free(task_table_t *t)
+{
+	if (!t)
+		return;
+	free_vector(t->slots);
+	free_vector(t->free_slots);
+	free(t->buckets);
+	free(t);
+}
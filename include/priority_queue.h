@@ -6,14 +6,23 @@
 #define PARENT(x) ((x - 1) / 2)
 #define LEFT_SON(x) (2 * x + 1)
 #define RIGHT_SON(x) (2 * x + 2)
+#define SWAP_BUFFER_SIZE 64
 
 
 typedef int (*comparator_t)(const void *, const void *);
 typedef void (*copy_t)(void *, void *, size_t);
+typedef void (*index_t)(void *, size_t);
 
+/** structure used to mimic std::priority_queue from C++.
+ * container = vector keeping the heap
+ * comp = comparator function used to compare keys
+ * set_index = optional function notified with the new position of an
+ * element each time it is moved inside the heap
+ */
 typedef struct {
 	vector_t *container;
 	comparator_t comp;
+	index_t set_index;
 } priority_queue_t;
 
 
@@ -61,6 +70,38 @@ void priority_queue_pop(priority_queue_t *pq);
  */
 void *priority_queue_top(priority_queue_t *pq);
 
+/**
+ * Retrieves the element at given index from the priority queue, the
+ * elements being in heap order.
+ * pq = priority queue pq
+ * index = position of the element in the priority queue
+ * @return the element or NULL if the index is out of bounds
+ */
+void *priority_queue_get(priority_queue_t *pq, size_t index);
+
+/**
+ * Reestablish the heap order after the key of an element was changed.
+ * pq = priority queue pq
+ * index = position of the changed element in the priority queue
+ */
+void priority_queue_update(priority_queue_t *pq, size_t index);
+
+/**
+ * Removes the element at given index from the priority queue.
+ * pq = priority queue pq
+ * index = position of the element in the priority queue
+ */
+void priority_queue_remove(priority_queue_t *pq, size_t index);
+
+/**
+ * Specifies how the position of the elements should be tracked.
+ * pq = priority queue pq
+ * set_index = function with 2 parameters
+ * @first_param = the address of the element inside the priority queue
+ * @second_param = the new position of the element
+ */
+void priority_queue_index_function(priority_queue_t *pq, index_t set_index);
+
 /**
  * Frees the data alocated from the priority queue;
  * pq = priority queue pq;
@@ -0,0 +1,104 @@
+/* Copyright Radu Nichita radunichita99@gmail.com */
+#ifndef __SO_SCHED_INTERNAL_H_
+#define __SO_SCHED_INTERNAL_H_
+
+#include "so_scheduler.h"
+
+/*
+ * Functions exported by the scheduler to the synchronization primitives
+ * built on top of it. Unless stated otherwise, they must be called with
+ * the scheduler lock held.
+ */
+
+/** bind a synchronization object to the scheduler of the calling thread
+ * if it is not bound yet. The queues of an object hold the threads of a
+ * single scheduler, woken up under its lock. Must be called without the
+ * lock held, before so_sched_enter.
+ * owner = scheduler the object is bound to, NULL until its first use
+ * @return SO_SUCCESS or SO_FAILURE if the object belongs to another
+ * scheduler
+ */
+int so_sched_bind(struct so_scheduler **owner);
+
+/** lock the scheduler and spend a time unit for the running thread.
+ * Must be called without the lock held.
+ * @return the running thread
+ */
+so_thread_t *so_sched_enter(void);
+
+/** unlock the scheduler and choose the next thread to run. If the running
+ * thread was parked, the function returns only after it is woken up.
+ */
+void so_sched_leave(void);
+
+/** initialize a queue of threads ordered by priority, then by timestamp
+ * @return the new queue
+ */
+priority_queue_t *so_sched_queue_init(void);
+
+/** add a thread in a queue of threads
+ * pq = queue of threads
+ * so_thread = thread to be added
+ */
+void so_sched_enqueue(priority_queue_t *pq, so_thread_t *so_thread);
+
+/** remove the thread with the highest priority from a queue of threads
+ * pq = queue of threads, should not be empty
+ * @return the removed thread
+ */
+so_thread_t *so_sched_dequeue(priority_queue_t *pq);
+
+/** mark the running thread as WAITING and add it in a queue of threads
+ * pq = queue of threads
+ */
+void so_sched_park(priority_queue_t *pq);
+
+/** mark the running thread as WAITING in a queue of a synchronization
+ * object, with a function undoing what it did in the object if it is
+ * cancelled before it is woken up
+ * pq = queue of threads
+ * cleanup = function run when the thread is cancelled in the queue
+ * object = synchronization object given to cleanup
+ */
+void so_sched_park_cleanup(priority_queue_t *pq, so_wait_cleanup_t cleanup,
+		void *object);
+
+/** mark a waiting thread as READY and add it in the scheduler queue
+ * so_thread = thread to be woken up
+ */
+void so_sched_wake(so_thread_t *so_thread);
+
+/** mark a waiting thread as READY after handing it something, with a
+ * function giving it back if the thread is cancelled before it runs again
+ * so_thread = thread to be woken up
+ * cleanup = function run when the thread is cancelled before it runs
+ * object = synchronization object given to cleanup
+ */
+void so_sched_wake_cleanup(so_thread_t *so_thread, so_wait_cleanup_t cleanup,
+		void *object);
+
+/** recompute the priority of a thread after its base priority or the
+ * waiters of its mutexes have changed, propagating it to the owners of
+ * the mutexes it waits for
+ * so_thread = thread to be updated
+ */
+void so_sched_update_priority(so_thread_t *so_thread);
+
+/*
+ * Functions exported by the synchronization primitives to the scheduler,
+ * called with the scheduler lock held.
+ */
+
+/** hand the task mutexes held by a thread which has terminated or was
+ * cancelled to the threads waiting for them
+ * owner = thread holding the mutexes
+ */
+void so_task_mutex_release_all(so_thread_t *owner);
+
+/** release the read-write locks held by a thread which has terminated or
+ * was cancelled
+ * owner = thread holding the locks
+ */
+void so_task_rwlock_release_all(so_thread_t *owner);
+
+#endif /* __SO_SCHED_INTERNAL_H_ */
@@ -1,8 +1,12 @@
 #ifndef __SO_SCHEDULER_H_
 #define __SO_SCHEDULER_H_
 
+#include <setjmp.h>
+
 #include "so_thread.h"
 #include "priority_queue.h"
+#include "task_table.h"
+#include "task_group.h"
 
 #define SHARE_THREADS 0
 #define SHARE_PROCESS 1
@@ -23,6 +27,72 @@
  */
 #define SO_MAX_DEVICE 256
 
+/*
+ * the maximum number of read-write locks a task may hold for reading
+ */
+#define SO_MAX_READ_LOCKS 8
+
+/*
+ * flag for tasks that are run on the context of the task dispatching them,
+ * if that task has terminated, instead of getting their own thread
+ */
+#define SO_TASK_INLINE 1
+
+/*
+ * flag for tasks whose handler runs in a separate process, so a crash of
+ * the handler does not bring down the scheduler. The handler may only call
+ * so_exec, so_yield, so_wait and so_signal.
+ */
+#define SO_TASK_PROCESS 2
+
+/*
+ * flag for task graphs whose priorities are given by the length of the
+ * longest path from each task to the end of the graph
+ */
+#define SO_TASK_DAG_CRITICAL_PATH 1
+
+/*
+ * actions taken when a task has spent its budget: lower its priority to
+ * SO_MIN_PRIORITY, cancel it or only mark it, see so_budget_exceeded
+ */
+#define SO_BUDGET_DEMOTE 0
+#define SO_BUDGET_CANCEL 1
+#define SO_BUDGET_REPORT 2
+
+/*
+ * the default and the maximum weight of a task group
+ */
+#define SO_GROUP_DEFAULT_WEIGHT TASK_GROUP_DEFAULT_WEIGHT
+#define SO_GROUP_MAX_WEIGHT TASK_GROUP_MAX_WEIGHT
+
+/*
+ * the maximum number of tasks running the chunks of a parallel loop
+ */
+#define SO_PARALLEL_WORKERS 4
+
+/*
+ * the maximum number of tasks moved by a call of so_sched_balance
+ */
+#define SO_BALANCE_MAX_MOVES 4
+
+/*
+ * ready tasks per scheduler above which so_sched_autoscale adds one and
+ * below which it removes one
+ */
+#define SO_SCALE_UP_READY 4
+#define SO_SCALE_DOWN_READY 1
+
+/*
+ * limits of the wake affine placement, see so_sched_set_wake_affine
+ */
+#define SO_WAKE_AFFINE_QUEUE 4
+#define SO_WAKE_AFFINE_MAX 2
+
+/*
+ * number of switches after which the adaptive quantum is adjusted
+ */
+#define SO_ADAPT_WINDOW 64
+
 /*
  * return value of failed tasks
  */
@@ -33,24 +103,33 @@ extern "C" {
 #endif
 
 
-#define LOCK(scheduler) so_mutex_lock(&scheduler.lock)
-#define UNLOCK(scheduler) so_mutex_unlock(&scheduler.lock)
+#define LOCK(scheduler) so_mutex_lock(&(scheduler)->lock)
+#define UNLOCK(scheduler) so_mutex_unlock(&(scheduler)->lock)
 #define WAIT_FOR_SCHEDULE(thread) so_semaphore_acquire(&(thread)->preempted)
 #define SCHEDULE_THREAD(thread) so_semaphore_release(&(thread)->preempted)
+#define TID_KEY(tid) ((unsigned long)(tid))
 #define SO_SUCCESS 0
 #define SO_FAILURE -1
+#define SO_BARRIER_SERIAL 1
+#define SO_JOIN_CANCELLED 1
 
 #define TRUE 1
 #define FALSE 0
 
 typedef vector_t so_vector_t;
 typedef void (*so_handler)(unsigned int);
+typedef void (*so_arg_handler)(void *);
+typedef void *(*so_future_handler)(void *);
+typedef void (*so_range_handler)(unsigned long, unsigned long, void *);
+typedef tid_t so_future_t;
+typedef task_group_t so_task_group_t;
 
 
 /** enum for possible threads states
  * NEW = thread was created.
  * READY = thread is ready to run
- * WAITING = thread is waiting for I/O
+ * WAITING = thread is waiting for I/O, for other threads to terminate or
+ * for a task mutex
  * RUNNING = thread is currently running.
  * TERMINATED = thread has finished.
  */
@@ -64,57 +143,313 @@ typedef enum {
 
 /** struct for keeping a thread argument
  * so_handler = pointer to the function to be executed
+ * arg_handler = pointer to the function to be executed with user_arg,
+ * used when handler is NULL
+ * future_handler = pointer to the function computing the result of the
+ * thread from user_arg, used when handler and arg_handler are NULL
+ * user_arg = argument given by the user to arg_handler
  * priority = priority of the thread to be executed.
+ * flags = SO_TASK_* flags given at fork
+ * budget = number of time units the thread may spend, 0 for no limit
+ * budget_action = SO_BUDGET_* action taken when the budget is spent
+ * group = group of the thread or NULL for the group of its parent
+ * cpu_mask = cpus whose schedulers the thread may be moved to, 0 for any
  */
 typedef struct {
 	so_handler handler;
+	so_arg_handler arg_handler;
+	so_future_handler future_handler;
+	void *user_arg;
 	unsigned int priority;
+	unsigned int flags;
+	unsigned long budget;
+	unsigned int budget_action;
+	so_task_group_t *group;
+	unsigned long cpu_mask;
 } so_thread_arg_t;
 
+/** struct for keeping the attributes of a new task
+ * priority = priority of the task
+ * flags = SO_TASK_* flags
+ * budget = number of time units the task may spend, 0 for no limit
+ * budget_action = SO_BUDGET_* action taken when the budget is spent
+ * group = group of the task or NULL for the group of the task forking it
+ * cpu_mask = bit mask of the cpus whose schedulers the task may be moved
+ * to, 0 for any scheduler
+ */
+typedef struct {
+	unsigned int priority;
+	unsigned int flags;
+	unsigned long budget;
+	unsigned int budget_action;
+	so_task_group_t *group;
+	unsigned long cpu_mask;
+} so_task_attr_t;
+
+typedef struct so_task_mutex so_task_mutex_t;
+typedef struct so_task_rwlock so_task_rwlock_t;
+typedef struct so_task_sem so_task_sem_t;
+
+/** function undoing what a thread did in a synchronization object before
+ * parking in one of its queues, run when the thread is cancelled there
+ * object = synchronization object
+ */
+typedef void (*so_wait_cleanup_t)(void *object);
+
+/** struct shared by a process task with the thread running it.
+ * reply = released when the call forwarded by the process has returned
+ * call = call forwarded by the process
+ * arg = argument of the call
+ * result = value returned by the call
+ * process = the process running the handler of the task
+ */
+typedef struct {
+	so_sem_t reply;
+	unsigned int call;
+	unsigned int arg;
+	int result;
+	so_process_t process;
+} so_process_call_t;
+
 /** struct for keeping a wrapper thread.
- * thread = thread id for the current thread
+ * tid = id of the task returned by so_fork
+ * thread = id of the thread running the task (differs from tid for
+ * inline tasks, INVALID_TID until an inline task is first dispatched)
  * thread_timestamp = current thread timestamp (used for adding in pq)
  * arg = wrapper for thread argument.
  * status = current status of the thread
  * remaining_time = remaining time for the current thread until preempted
+ * pq_index = position of the thread in the pq while it is READY
+ * handle = handle of the thread in the task table
+ * joiners = threads waiting for the current thread to terminate
+ * join_pending = number of threads the current thread is waiting for
+ * has_context = whether a thread was assigned to run the task
+ * own_context = whether the thread was created for this task
+ * base_priority = priority given by the user, arg.priority may be higher
+ * because of the priority inheritance
+ * queue = priority queue the thread is in (pq or mutex waiters) or NULL
+ * owned_mutexes = list of task mutexes held by the thread
+ * blocked_on = task mutex the thread is waiting for or NULL
+ * read_locks = read-write locks held by the thread for reading, once for
+ * each time it took them
+ * num_read_locks = number of entries in read_locks
+ * written_locks = list of read-write locks held by the thread for writing
+ * wait_cleanup = function run if the thread is cancelled while parked in
+ * the queue of a synchronization object, or after being woken up with
+ * something handed over by the object and before running again, or NULL
+ * wait_object = synchronization object given to wait_cleanup
+ * wait_data = element a thread parked on a channel sends or receives
+ * result = value returned by the future handler of the thread
+ * cancelled = whether the thread was cancelled by so_kill
+ * exit_point = where the thread leaves its handler when it is cancelled,
+ * set only while the handler runs
+ * used_time = number of time units spent by the thread
+ * budget_exceeded = whether the thread has spent its budget
+ * group = group the thread is scheduled in
+ * sched = scheduler the thread belongs to
+ * process = call slot shared with the process running the handler of a
+ * process task, while it runs
+ * last_run = clock of its scheduler when the thread was last dispatched,
+ * 0 if it has never run. A thread moved to another scheduler keeps the
+ * time since then, counted on the clock of the new scheduler.
  */
-typedef struct {
+typedef struct so_thread {
+	tid_t tid;
 	tid_t thread;
 	unsigned long thread_timestamp;
 	so_sem_t preempted;
 	so_thread_arg_t arg;
 	so_thread_status_t status;
 	unsigned int remaining_time;
+	size_t pq_index;
+	task_handle_t handle;
+	vector_t *joiners;
+	unsigned int join_pending;
+	SO_BOOL has_context;
+	SO_BOOL own_context;
+	unsigned int base_priority;
+	priority_queue_t *queue;
+	so_task_mutex_t *owned_mutexes;
+	so_task_mutex_t *blocked_on;
+	so_task_rwlock_t *read_locks[SO_MAX_READ_LOCKS];
+	unsigned int num_read_locks;
+	so_task_rwlock_t *written_locks;
+	so_wait_cleanup_t wait_cleanup;
+	void *wait_object;
+	void *wait_data;
+	void *result;
+	SO_BOOL cancelled;
+	jmp_buf *exit_point;
+	unsigned long used_time;
+	SO_BOOL budget_exceeded;
+	so_task_group_t *group;
+	struct so_scheduler *sched;
+	so_process_call_t *process;
+	unsigned long last_run;
 } so_thread_t;
 
+/** struct for keeping a mutex between tasks.
+ * owner = task holding the mutex or NULL
+ * waiters = tasks waiting for the mutex, ordered by priority
+ * next_owned = next mutex in the list of mutexes held by the owner
+ * sched = scheduler of the tasks using the mutex, set by the first of them
+ */
+struct so_task_mutex {
+	so_thread_t *owner;
+	priority_queue_t *waiters;
+	so_task_mutex_t *next_owned;
+	struct so_scheduler *sched;
+};
+
+/** struct for keeping a counting semaphore between tasks.
+ * value = number of available permits
+ * waiters = tasks waiting for a permit, ordered by priority
+ * sched = scheduler of the tasks using the semaphore, set by the first of
+ * them
+ */
+struct so_task_sem {
+	unsigned int value;
+	priority_queue_t *waiters;
+	struct so_scheduler *sched;
+};
+
+/** struct for keeping a barrier between tasks.
+ * count = number of tasks that need to reach the barrier
+ * arrived = number of tasks waiting at the barrier
+ * waiters = tasks waiting at the barrier, ordered by priority
+ * sched = scheduler of the tasks using the barrier, set by the first of them
+ */
+typedef struct {
+	unsigned int count;
+	unsigned int arrived;
+	priority_queue_t *waiters;
+	struct so_scheduler *sched;
+} so_task_barrier_t;
+
+/** struct for keeping a read-write lock between tasks.
+ * readers = number of tasks holding the lock for reading
+ * writer = task holding the lock for writing or NULL
+ * waiting_readers = tasks waiting to read, ordered by priority
+ * waiting_writers = tasks waiting to write, ordered by priority
+ * next_written = next lock in the list of locks held by the writer
+ * sched = scheduler of the tasks using the lock, set by the first of them
+ */
+struct so_task_rwlock {
+	unsigned int readers;
+	so_thread_t *writer;
+	priority_queue_t *waiting_readers;
+	priority_queue_t *waiting_writers;
+	so_task_rwlock_t *next_written;
+	struct so_scheduler *sched;
+};
+
+/** struct for keeping a task of a task graph
+ * handler = function to be executed with arg
+ * arg = argument given to the handler
+ * priority = priority of the task, unless it is given by the critical path
+ */
+typedef struct {
+	so_arg_handler handler;
+	void *arg;
+	unsigned int priority;
+} so_task_dag_node_t;
+
+/** struct for keeping a dependency of a task graph
+ * from = index of the task that must terminate first
+ * to = index of the task that depends on it
+ */
+typedef struct {
+	unsigned int from;
+	unsigned int to;
+} so_task_dag_edge_t;
+
+/** struct for keeping a bounded channel between tasks.
+ * buffer = ring buffer of capacity elements of elem_size bytes
+ * elem_size = size of an element
+ * capacity = maximum number of buffered elements
+ * head = index of the oldest buffered element
+ * count = number of buffered elements
+ * senders = tasks waiting for free space, ordered by priority
+ * receivers = tasks waiting for an element, ordered by priority
+ * sched = scheduler of the tasks using the channel, set by the first of
+ * them
+ */
+typedef struct {
+	char *buffer;
+	size_t elem_size;
+	unsigned int capacity;
+	unsigned int head;
+	unsigned int count;
+	priority_queue_t *senders;
+	priority_queue_t *receivers;
+	struct so_scheduler *sched;
+} so_task_chan_t;
+
 /** struct for keeping the scheduler.
- * q_time = scheduler quantun time.
+ * q_time = scheduler quantun time for each priority.
  * num_io_devices = maximum number of io devices supportted
  * initialized = variable to checker whether the scheduler has
  * been initialized.
- * pq = priority_queue for maintaing thread ordering (round-robin)
+ * root_group = group of the tasks not forked in another group, its tree
+ * keeps the ready threads ordered by shares, then by priority
+ * clock = number of time units spent since so_init
+ * timestamp = counter ordering the threads of the same priority
+ * cpu = cpu the threads of the scheduler are pinned to or -1
+ * gang = gang group whose ready threads are run in turn or NULL
+ * gang_turns = number of threads of the gang left to run in this turn
+ * wake_affine = whether the threads woken by so_signal are placed in front
+ * of their priority
+ * adapt_target = switch overhead in percent the adaptive quantum aims for,
+ * 0 if the quantum is not adaptive
+ * adapt_min, adapt_max = bounds of the adaptive quantum
+ * adapt_quantum = quantum of all the priorities while it is adaptive
+ * adapt_switches = number of switches measured in the current window
+ * switch_ns = time spent switching in the current window
+ * window_start = time the current window started
+ * switch_start = time the last switch started
+ * carry_over = whether a thread preempted by a higher priority keeps the
+ * rest of its quantum and its place
  * running_thread = thread wrapper structure of the running thread
  * num_active_thread = number of active threads
  * terminated_threads = a vector / list of terminated threads
+ * tasks = table of the threads not reaped yet, indexed by handle and tid
  * lock = lock for the scheduler
  * waiting_threads = vector of threads waiting on specific I/O device
  *		waiting_threads[i] = threads waiting for the ith I/O device
  * finish_cond = conditional variable to wait for threads to complete
  */
-typedef struct {
-	unsigned int q_time;
+typedef struct so_scheduler {
+	unsigned int q_time[SO_MAX_PRIORITY + 1];
 	unsigned int num_io_devices;
 	SO_BOOL initialized;
-	priority_queue_t *pq;
+	task_group_t *root_group;
+	unsigned long clock;
+	unsigned long timestamp;
+	int cpu;
+	task_group_t *gang;
+	size_t gang_turns;
+	SO_BOOL wake_affine;
+	unsigned int adapt_target;
+	unsigned int adapt_min;
+	unsigned int adapt_max;
+	unsigned int adapt_quantum;
+	unsigned int adapt_switches;
+	unsigned long long switch_ns;
+	unsigned long long window_start;
+	unsigned long long switch_start;
+	SO_BOOL carry_over;
 	so_thread_t *running_thread;
 	int num_active_threads;
 	vector_t *terminated_threads;
 	int num_terminated_threads;
+	task_table_t *tasks;
 	so_mutex_t lock;
 	vector_t *waiting_threads_io[SO_MAX_DEVICE];
 	so_cond_t finish_cond;
 } so_scheduler_t;
 
+typedef so_scheduler_t so_sched_t;
+
 /*
  * creates and initializes scheduler
  * + time quantum for each thread
@@ -123,6 +458,18 @@ typedef struct {
  */
 DECL_PREFIX int so_init(unsigned int time_quantum, unsigned int io);
 
+/*
+ * creates and initializes scheduler with a time quantum for each priority,
+ * e.g. longer ones for the batch tasks with a low priority, to switch less
+ * often, and shorter ones for the interactive tasks with a high priority,
+ * to answer faster
+ * + time quantum for each priority, SO_MAX_PRIORITY + 1 values
+ * + number of IO devices supported
+ * returns: 0 on success or negative on error
+ */
+DECL_PREFIX int so_init_quanta(const unsigned int *time_quanta,
+		unsigned int io);
+
 /*
  * creates a new so_task_t and runs it according to the scheduler
  * + handler function
@@ -131,6 +478,42 @@ DECL_PREFIX int so_init(unsigned int time_quantum, unsigned int io);
  */
 DECL_PREFIX tid_t so_fork(so_handler func, unsigned int priority);
 
+/*
+ * creates a new so_task_t which receives an argument
+ * + handler function
+ * + argument given to the handler
+ * + priority
+ * returns: tid of the new task if successful or INVALID_TID
+ */
+DECL_PREFIX tid_t so_fork_arg(so_arg_handler func, void *arg,
+			unsigned int priority);
+
+/*
+ * creates a new so_task_t whose result can be taken with so_future_get
+ * + handler function returning the result
+ * + argument given to the handler
+ * + priority
+ * returns: future of the new task if successful or INVALID_TID
+ */
+DECL_PREFIX so_future_t so_fork_future(so_future_handler func, void *arg,
+			unsigned int priority);
+
+/*
+ * initializes the attributes of a task with the default values
+ * + attributes
+ */
+DECL_PREFIX void so_task_attr_init(so_task_attr_t *attr);
+
+/*
+ * creates a new so_task_t with the given attributes
+ * + handler function
+ * + argument given to the handler
+ * + attributes (priority, flags)
+ * returns: tid of the new task if successful or INVALID_TID
+ */
+DECL_PREFIX tid_t so_fork_attr(so_arg_handler func, void *arg,
+			const so_task_attr_t *attr);
+
 /*
  * waits for an IO device
  * + device index
@@ -150,6 +533,466 @@ DECL_PREFIX int so_signal(unsigned int io);
  */
 DECL_PREFIX void so_exec(void);
 
+/*
+ * gives up the rest of the quantum to a task with the same priority
+ */
+DECL_PREFIX void so_yield(void);
+
+/*
+ * changes the priority of a task
+ * + tid of the task
+ * + new priority
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_set_priority(tid_t tid, unsigned int priority);
+
+/*
+ * cancels a task. A task which is not running is removed from the queue it
+ * waits in and terminated right away, the running task leaves its handler
+ * at the next scheduling point. The task mutexes and read-write locks it
+ * holds are released. Task semaphore permits have no owner, so the ones it
+ * took are not given back, except for a permit handed to it by a post
+ * while it was waiting and before it ran again. A task cancelled while
+ * waiting at a barrier no longer counts as arrived.
+ * + tid of the task
+ * returns: -1 if the task does not exist or has terminated or 0 on success
+ */
+DECL_PREFIX int so_kill(tid_t tid);
+
+/*
+ * checks if a task has spent the budget given at fork
+ * + tid of the task
+ * returns: 1 if it has, 0 if it has not or -1 if the task does not exist
+ */
+DECL_PREFIX int so_budget_exceeded(tid_t tid);
+
+/*
+ * gets the tid of the calling task
+ * returns: the tid or INVALID_TID if the caller is not a task
+ */
+DECL_PREFIX tid_t so_self(void);
+
+/*
+ * waits for a task to terminate
+ * + tid of the task
+ * returns: -1 if the task does not exist, SO_JOIN_CANCELLED if it was
+ * cancelled or 0 if it ended by itself
+ */
+DECL_PREFIX int so_join(tid_t tid);
+
+/*
+ * waits for a group of tasks to terminate
+ * + tids of the tasks
+ * + number of tasks
+ * returns: -1 if the tids are missing or any of the tasks does not exist,
+ * SO_JOIN_CANCELLED if any of them was cancelled or 0 on success
+ */
+DECL_PREFIX int so_wait_all(const tid_t *tids, unsigned int count);
+
+/*
+ * waits for the task of a future to terminate and takes its result
+ * + future
+ * + where the result is stored
+ * returns: -1 if the future does not exist or was cancelled or 0 on
+ * success
+ */
+DECL_PREFIX int so_future_get(so_future_t future, void **result);
+
+/*
+ * initializes a mutex shared by tasks
+ * + mutex
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_task_mutex_init(so_task_mutex_t *mutex);
+
+/*
+ * locks a mutex, waiting for it if it is held by another task. The owner
+ * inherits the priority of the tasks waiting for the mutex, those of other
+ * groups included. The priority orders only the tasks of a group, so the
+ * owner gets ahead of the other tasks of its group, but its group still
+ * waits for its turn by its weight.
+ * + mutex
+ * returns: 0 on success or -1 if the mutex is already held by the caller
+ * or is not valid
+ */
+DECL_PREFIX int so_task_mutex_lock(so_task_mutex_t *mutex);
+
+/*
+ * unlocks a mutex and hands it to the waiting task with the highest
+ * priority
+ * + mutex
+ * returns: 0 on success or -1 if the mutex is not held by the caller or is
+ * not valid
+ */
+DECL_PREFIX int so_task_mutex_unlock(so_task_mutex_t *mutex);
+
+/*
+ * destroys a mutex shared by tasks
+ * + mutex
+ */
+DECL_PREFIX void so_task_mutex_destroy(so_task_mutex_t *mutex);
+
+/*
+ * initializes a counting semaphore shared by tasks
+ * + semaphore
+ * + initial number of permits
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_task_sem_init(so_task_sem_t *sem, unsigned int value);
+
+/*
+ * takes a permit, waiting for one if there is none available
+ * + semaphore
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_task_sem_wait(so_task_sem_t *sem);
+
+/*
+ * releases a permit, handing it to the waiting task with the highest
+ * priority
+ * + semaphore
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_task_sem_post(so_task_sem_t *sem);
+
+/*
+ * destroys a counting semaphore shared by tasks
+ * + semaphore
+ */
+DECL_PREFIX void so_task_sem_destroy(so_task_sem_t *sem);
+
+/*
+ * initializes a barrier shared by tasks
+ * + barrier
+ * + number of tasks that need to reach the barrier
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_task_barrier_init(so_task_barrier_t *barrier,
+			unsigned int count);
+
+/*
+ * waits until all the tasks reach the barrier
+ * + barrier
+ * returns: SO_BARRIER_SERIAL for the last task reaching the barrier,
+ * 0 for the others or -1 on error
+ */
+DECL_PREFIX int so_task_barrier_wait(so_task_barrier_t *barrier);
+
+/*
+ * destroys a barrier shared by tasks
+ * + barrier
+ */
+DECL_PREFIX void so_task_barrier_destroy(so_task_barrier_t *barrier);
+
+/*
+ * initializes a read-write lock shared by tasks
+ * + lock
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_task_rwlock_init(so_task_rwlock_t *rwlock);
+
+/*
+ * locks for reading, waiting while a task writes or while a task with a
+ * higher priority waits to write
+ * + lock
+ * returns: 0 on success or -1 on error or if the caller already holds
+ * SO_MAX_READ_LOCKS locks for reading
+ */
+DECL_PREFIX int so_task_rwlock_rdlock(so_task_rwlock_t *rwlock);
+
+/*
+ * locks for writing, waiting while other tasks hold the lock
+ * + lock
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_task_rwlock_wrlock(so_task_rwlock_t *rwlock);
+
+/*
+ * unlocks a read-write lock held by the caller, for writing or reading
+ * + lock
+ * returns: 0 on success or -1 if the lock is not held by the caller
+ */
+DECL_PREFIX int so_task_rwlock_unlock(so_task_rwlock_t *rwlock);
+
+/*
+ * destroys a read-write lock shared by tasks
+ * + lock
+ */
+DECL_PREFIX void so_task_rwlock_destroy(so_task_rwlock_t *rwlock);
+
+/*
+ * initializes a bounded channel shared by tasks
+ * + channel
+ * + size of an element
+ * + maximum number of buffered elements
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_task_chan_init(so_task_chan_t *chan, size_t elem_size,
+			unsigned int capacity);
+
+/*
+ * sends an element, waiting while the channel is full
+ * + channel
+ * + element
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_task_chan_send(so_task_chan_t *chan, const void *elem);
+
+/*
+ * receives the oldest element, waiting while the channel is empty
+ * + channel
+ * + buffer for the element
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_task_chan_recv(so_task_chan_t *chan, void *elem);
+
+/*
+ * sends a group of elements in order, waiting while the channel is full
+ * + channel
+ * + elements
+ * + number of elements
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_task_chan_send_many(so_task_chan_t *chan,
+			const void *elems, unsigned int count);
+
+/*
+ * receives up to count elements, waiting only while the channel is empty
+ * + channel
+ * + buffer for the elements
+ * + maximum number of elements
+ * returns: number of elements received or -1 on error
+ */
+DECL_PREFIX int so_task_chan_recv_many(so_task_chan_t *chan, void *elems,
+			unsigned int count);
+
+/*
+ * destroys a bounded channel shared by tasks
+ * + channel
+ */
+DECL_PREFIX void so_task_chan_destroy(so_task_chan_t *chan);
+
+/*
+ * runs a graph of tasks and waits for all of them to terminate. A task is
+ * forked only after all the tasks it depends on have ended by themselves:
+ * the tasks depending on a cancelled task are skipped.
+ * + tasks
+ * + number of tasks
+ * + dependencies
+ * + number of dependencies
+ * + SO_TASK_DAG_* flags
+ * returns: 0 on success or -1 if the graph is not valid or has cycles or
+ * a task was cancelled
+ */
+DECL_PREFIX int so_task_dag_run(const so_task_dag_node_t *nodes,
+			unsigned int num_nodes, const so_task_dag_edge_t *edges,
+			unsigned int num_edges, unsigned int flags);
+
+/*
+ * runs a handler over the chunks of a range of indexes and waits for all
+ * of them to finish. The chunks are taken one by one by a few worker
+ * tasks, not by a task for each chunk.
+ * + first index of the range
+ * + index after the last one
+ * + maximum number of indexes in a chunk
+ * + handler called with the first and after-last index of each chunk
+ * + argument given to the handler
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_parallel_for(unsigned long begin, unsigned long end,
+			unsigned long grain, so_range_handler func, void *arg);
+
+/*
+ * creates a group of tasks, which gets a share of the time of its parent
+ * proportional to its weight
+ * + parent group or NULL for the root group
+ * + weight, from 1 to SO_GROUP_MAX_WEIGHT
+ * returns: the new group or NULL on error
+ */
+DECL_PREFIX so_task_group_t *so_task_group_create(so_task_group_t *parent,
+			unsigned int weight);
+
+/*
+ * limits the time units a group and its subgroups may run in each period
+ * + group
+ * + number of units in a period, 0 for no limit
+ * + length of a period in units
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_task_group_set_quota(so_task_group_t *group,
+			unsigned long quota, unsigned long period);
+
+/*
+ * makes a group a gang: once it is chosen, each of its ready tasks runs a
+ * quantum, one after another, before another group is chosen, so tasks
+ * working together make progress together
+ * + group
+ * + 1 to make the group a gang, 0 to make it a regular group
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_task_group_set_gang(so_task_group_t *group, int gang);
+
+/*
+ * destroys a group with no subgroups and no tasks left
+ * + group
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_task_group_destroy(so_task_group_t *group);
+
+/*
+ * creates and initializes a scheduler independent of the default one, with
+ * its own tasks and lock. A task mutex, semaphore, barrier, read-write lock
+ * or channel belongs to the scheduler of the first task using it: the
+ * calls of the tasks of other schedulers on it fail.
+ * + time quantum for each thread
+ * + number of IO devices supported
+ * returns: the scheduler or NULL on error
+ */
+DECL_PREFIX so_sched_t *so_sched_create(unsigned int time_quantum,
+			unsigned int io);
+
+/*
+ * makes the calling thread use a scheduler for the calls of the API. The
+ * tasks of a scheduler always use it: called by a task with another
+ * scheduler, it changes nothing and fails.
+ * + scheduler or NULL for the default one, initialized by so_init
+ * returns: the scheduler used before or NULL if the caller is a task of
+ * another scheduler
+ */
+DECL_PREFIX so_sched_t *so_sched_use(so_sched_t *sched);
+
+/*
+ * waits for the tasks of a scheduler created by so_sched_create and
+ * destroys it
+ * + scheduler
+ */
+DECL_PREFIX void so_sched_destroy(so_sched_t *sched);
+
+/*
+ * changes the time quantum of a priority. The tasks with that priority get
+ * it starting with their next quantum.
+ * + priority
+ * + time quantum
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_sched_set_quantum(unsigned int priority,
+		unsigned int time_quantum);
+
+/*
+ * makes the quantum adaptive: the time the tasks spend switching is
+ * measured and, every SO_ADAPT_WINDOW switches, the quantum is doubled
+ * while the switches take more than the target part of the time and halved
+ * while they take less than half of it. While it is adaptive, all the
+ * priorities get the same quantum, starting with the lower bound.
+ * + lower bound of the quantum
+ * + upper bound of the quantum
+ * + target switch overhead in percent, less than 100, or 0 to go back to
+ * the quantum of each priority
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_sched_set_adaptive(unsigned int min_quantum,
+		unsigned int max_quantum, unsigned int target);
+
+/*
+ * gets the quantum a priority gets now
+ * + priority
+ * returns: the quantum or 0 on error
+ */
+DECL_PREFIX unsigned int so_sched_get_quantum(unsigned int priority);
+
+/*
+ * makes a task preempted by a task with a higher priority keep the rest of
+ * its quantum and go back at the head of its priority, instead of getting
+ * a new quantum at the end of it, so the tasks with a lower priority
+ * advance at the same pace under bursts of tasks with a higher priority
+ * + 1 to keep the quantum, 0 to start a new one
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_sched_set_carry_over(int enable);
+
+/*
+ * places the tasks woken by so_signal in front of the ready tasks with
+ * their priority, instead of at the end, so they run right after the
+ * signalling task while its data is still in the cache. It is done only
+ * while their group has less than SO_WAKE_AFFINE_QUEUE ready tasks and for
+ * the first SO_WAKE_AFFINE_MAX tasks woken by a signal.
+ * + 1 to enable the placement, 0 to disable it
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_sched_set_wake_affine(int enable);
+
+/*
+ * pins the threads the scheduler creates from now on to a cpu. Only one task
+ * runs at a time, so keeping them on one cpu saves the cost of waking a
+ * thread on another cpu and moving its data there at every switch.
+ * A task whose thread cannot be pinned, because the cpu is outside the
+ * affinity mask of the process, is not forked. An inline task, which
+ * gets its thread later, runs on any cpu instead.
+ * + cpu or -1 to let the threads run on any cpu
+ * returns: 0 on success or -1 if the cpu index is not valid
+ */
+DECL_PREFIX int so_sched_set_cpu(int cpu);
+
+/*
+ * moves a ready task of the scheduler of the caller to another scheduler,
+ * at the end of its priority. Tasks joined by others, holding task
+ * mutexes or read-write locks or woken up with a semaphore permit they
+ * have not taken yet stay where they are, as do the tasks whose thread
+ * cannot be pinned to the cpu of the other scheduler. A moved task can no
+ * longer use the synchronization objects of its old scheduler.
+ * + tid of the task
+ * + scheduler the task is moved to
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_sched_migrate(tid_t tid, so_sched_t *to);
+
+/*
+ * moves all the ready tasks that can be moved, as so_sched_migrate does,
+ * to another scheduler, before this one is destroyed or left idle
+ * + scheduler the tasks are moved to
+ * returns: the number of tasks moved or -1 on error
+ */
+DECL_PREFIX int so_sched_drain(so_sched_t *to);
+
+/*
+ * gets the number of ready tasks of a scheduler, from which the number of
+ * schedulers may be adjusted
+ * + scheduler or NULL for the one of the caller
+ * returns: the number of ready tasks or -1 on error
+ */
+DECL_PREFIX int so_sched_ready_tasks(so_sched_t *sched);
+
+/*
+ * moves ready tasks from the most loaded scheduler of a set to the least
+ * loaded one, to be called periodically. The load of a scheduler is the
+ * sum of the priorities of its ready tasks, plus one for each. The tasks
+ * which have not run for the longest time are moved first, at most
+ * SO_BALANCE_MAX_MOVES at a call, and only while the receiving scheduler
+ * stays less loaded.
+ * + schedulers
+ * + number of schedulers
+ * returns: the number of tasks moved or -1 on error
+ */
+DECL_PREFIX int so_sched_balance(so_sched_t **scheds, unsigned int count);
+
+/*
+ * adjusts the number of schedulers of a set to its ready tasks, to be
+ * called periodically, like so_sched_balance. While there are more than
+ * SO_SCALE_UP_READY ready tasks for each scheduler, a new one, with the
+ * quanta and devices of the first, is added at the end of the set and
+ * balanced with the others. It is not pinned to a cpu. While the others
+ * would have less than SO_SCALE_DOWN_READY each, the last one is drained
+ * into the least loaded of them and destroyed, once it has no task left
+ * and unless it is the default scheduler or the one of the caller.
+ * At most one scheduler is added or removed at a call.
+ * + schedulers, with room for max of them
+ * + number of schedulers, updated
+ * + maximum number of schedulers
+ * returns: 0 on success or -1 on error
+ */
+DECL_PREFIX int so_sched_autoscale(so_sched_t **scheds, unsigned int *count,
+		unsigned int max);
+
 /*
  * destroys a scheduler
  */
@@ -11,7 +11,9 @@
 #define STATIC_MUTEX
 #include <pthread.h>
 #include <semaphore.h>
+#include <sys/types.h>
 #define DECL_PREFIX
+#define SO_THREAD_LOCAL __thread
 typedef int SO_BOOL;
 typedef pthread_t tid_t;
 typedef pthread_mutex_t so_mutex_t;
@@ -19,6 +21,15 @@ typedef pthread_cond_t so_cond_t;
 typedef volatile int so_spinlock_t;
 typedef sem_t so_sem_t;
 
+/** struct for keeping a process created by so_create_process.
+ * pid = id of the process
+ * doorbell = pipe the process writes to when it notifies its parent
+ */
+typedef struct {
+	pid_t pid;
+	int doorbell[2];
+} so_process_t;
+
 #elif defined(_WIN32)
 #include "windows.h"
 
@@ -28,12 +39,14 @@ typedef sem_t so_sem_t;
 #define DECL_PREFIX __declspec(dllexport)
 #endif
 
+#define SO_THREAD_LOCAL __declspec(thread)
 typedef BOOL SO_BOOL;
 typedef DWORD tid_t;
 typedef HANDLE so_mutex_t;
 typedef HANDLE so_cond_t;
 typedef HANDLE so_spinlock_t;
 typedef HANDLE so_sem_t;
+typedef HANDLE so_process_t;
 #else
     #error "unknown platform"
 #endif
@@ -118,6 +131,14 @@ SO_BOOL so_condition_notify(so_cond_t *so_cond);
  */
 SO_BOOL so_semaphore_init(so_sem_t *so_sem, int sem_value);
 
+/** initialize a semaphore shared between processes. The semaphore has to
+ * be placed in memory allocated with so_shared_alloc.
+ * so_sem = semaphore to be initialized
+ * sem_value = initial number of perms of the semaphore sem
+ * @return TRUE if could initialize semaphore and FALSE otherwise
+ */
+SO_BOOL so_semaphore_init_shared(so_sem_t *so_sem, int sem_value);
+
 /** acquire a semaphore -> The function blocks if there is no available
  * permission.
  * so_sem = semaphore to be acquired
@@ -149,12 +170,99 @@ SO_BOOL so_semaphore_destroy(so_sem_t *so_sem);
 SO_BOOL so_create_thread(tid_t *so_thread,
 					void* (*routine)(void *), void *arg);
 
+/** creates a new thread as so_create_thread does, pinned to a cpu before
+ * it starts running
+ * so_thread = the id of the newly create thread, an output variable
+ * routine = a pointer to the function to be executed.
+ * arg = argument of the function to be executed.
+ * cpu = index of the cpu or -1 to let the thread run on any cpu
+ * @return TRUE if the thread could be created and pinned and FALSE
+ * otherwise, in which case no thread is left running.
+ */
+SO_BOOL so_create_thread_on(tid_t *so_thread,
+			void* (*routine)(void *), void *arg, int cpu);
+
+/** allocates memory shared with the processes created afterwards
+ * size = size of the memory
+ * @return the memory, filled with zeros, or NULL on error
+ */
+void *so_shared_alloc(size_t size);
+
+/** releases memory allocated with so_shared_alloc
+ * mem = memory to be released
+ * size = size given at allocation
+ */
+void so_shared_free(void *mem, size_t size);
+
+/** creates a process, copy of the calling one, that runs routine with arg
+ * and then exits
+ * process = the new process, output variable
+ * routine = function run by the new process
+ * arg = argument of the function
+ * @return TRUE if the process could be created and FALSE otherwise.
+ */
+SO_BOOL so_create_process(so_process_t *process, void (*routine)(void *),
+				void *arg);
+
+/** called from a process created with so_create_process to wake up its
+ * parent, which waits in so_process_wait
+ * process = the calling process
+ * @return TRUE if the parent was notified and FALSE otherwise.
+ */
+SO_BOOL so_process_notify(so_process_t *process);
+
+/** waits for a notification from a process created with so_create_process
+ * process = the process
+ * @return TRUE if the process has notified and FALSE if it has exited.
+ */
+SO_BOOL so_process_wait(so_process_t *process);
+
+/** kills a process created with so_create_process, if it is still alive,
+ * and releases it
+ * process = the process
+ * @return TRUE if the process had exited by itself with success and FALSE
+ * otherwise.
+ */
+SO_BOOL so_process_end(so_process_t *process);
+
+/** pins a thread to a cpu
+ * so_thread = the thread
+ * cpu = index of the cpu
+ * @return TRUE if the thread was pinned and FALSE otherwise.
+ */
+SO_BOOL so_set_thread_cpu(tid_t so_thread, int cpu);
+
+/** check if a cpu index can be given to so_set_thread_cpu
+ * cpu = index of the cpu
+ * @return TRUE if the index fits in a cpu set and FALSE otherwise. A cpu
+ * outside the affinity mask of the process passes, pinning a thread on it
+ * fails.
+ */
+SO_BOOL so_cpu_valid(int cpu);
+
+/** get the time of a monotonic clock, to measure intervals
+ * @return the time in nanoseconds
+ */
+unsigned long long so_time_ns(void);
+
 /** joins a thread with current thread
  * thread = thread to be joined
  * @return TRUE if thread could be joined and FALSE otherwise.
  */
 SO_BOOL so_join_thread(tid_t so_thread);
 
+/** get the id of the calling thread
+ * @return the id of the calling thread.
+ */
+tid_t so_thread_self(void);
+
+/** compares two thread ids
+ * first = id of the first thread
+ * second = id of the second thread
+ * @return TRUE if the ids refer the same thread and FALSE otherwise.
+ */
+SO_BOOL so_equal_threads(tid_t first, tid_t second);
+
 #endif /* _SO_THREAD_H_ */
 
 
@@ -0,0 +1,117 @@
+/* Copyright Radu Nichita radunichita99@gmail.com */
+#ifndef __TASK_GROUP_H_
+#define __TASK_GROUP_H_
+
+#include "priority_queue.h"
+
+#define TASK_GROUP_STRIDE (1UL << 20)
+#define TASK_GROUP_DEFAULT_WEIGHT 100
+#define TASK_GROUP_MAX_WEIGHT 10000
+
+typedef struct task_group task_group_t;
+
+/** structure used to keep a group of tasks. The ready tasks of a group
+ * compete with its subgroups as if they were one more subgroup with the
+ * default weight. Each of them advances its pass by a stride inversely
+ * proportional to its weight for each unit it runs, and the one with the
+ * smallest pass is chosen.
+ * parent = group containing this one or NULL for the root group
+ * children = first subgroup
+ * next_sibling = next subgroup of the parent
+ * weight = share of the group among its siblings
+ * pass = virtual time of the group among its siblings
+ * own_pass = virtual time of the ready tasks of the group among the
+ * subgroups
+ * vtime = pass of the subgroup or own tasks run last, given to the ones
+ * becoming ready, so they do not run for the time they were idle
+ * ready = ready tasks of the group
+ * nr_ready = number of ready tasks of the group and of its subgroups
+ * nr_tasks = number of tasks of the group not terminated yet
+ * quota = number of units the group and its subgroups may run in a
+ * period, 0 for no limit
+ * period = length of the period of the quota
+ * used = number of units run in the current period
+ * period_index = index of the current period
+ * gang = whether the ready tasks of the group run one after another once
+ * the group is chosen
+ */
+struct task_group {
+	task_group_t *parent;
+	task_group_t *children;
+	task_group_t *next_sibling;
+	unsigned int weight;
+	unsigned long pass;
+	unsigned long own_pass;
+	unsigned long vtime;
+	priority_queue_t *ready;
+	size_t nr_ready;
+	size_t nr_tasks;
+	unsigned long quota;
+	unsigned long period;
+	unsigned long used;
+	unsigned long period_index;
+	int gang;
+};
+
+/**
+ * Initialize a group and add it to its parent.
+ * parent = parent group or NULL for a root group
+ * weight = share of the group among its siblings
+ * ready = queue for the ready tasks of the group
+ * @return the new group or NULL
+ */
+task_group_t *task_group_init(task_group_t *parent, unsigned int weight,
+				priority_queue_t *ready);
+
+/**
+ * Add a ready task in a group.
+ * g = group of the task
+ * data = element of the ready queue
+ */
+void task_group_push(task_group_t *g, void *data);
+
+/**
+ * Remove a ready task from a group.
+ * g = group of the task
+ * index = position of the task in the ready queue of the group
+ */
+void task_group_remove(task_group_t *g, size_t index);
+
+/**
+ * Choose the group whose first ready task should run next. Groups over
+ * their quota are chosen only if there is no other ready task.
+ * root = root group
+ * clock = number of units run since the start
+ * @return the group or NULL if there is no ready task
+ */
+task_group_t *task_group_pick(task_group_t *root, unsigned long clock);
+
+/**
+ * Account a unit run by a task of a group.
+ * g = group of the task
+ * clock = number of units run since the start, including this one
+ */
+void task_group_charge(task_group_t *g, unsigned long clock);
+
+/**
+ * Check if a group or one of its ancestors has run its quota.
+ * g = group
+ * clock = number of units run since the start
+ * @return 1 if it has, 0 otherwise
+ */
+int task_group_throttled(task_group_t *g, unsigned long clock);
+
+/**
+ * Remove a group with no subgroups from its parent and free it,
+ * together with its ready queue.
+ * g = group
+ */
+void task_group_free(task_group_t *g);
+
+/**
+ * Free a group with all its subgroups.
+ * g = group
+ */
+void task_group_free_all(task_group_t *g);
+
+#endif /* __TASK_GROUP_H_ */
@@ -0,0 +1,101 @@
+/* Copyright Radu Nichita radunichita99@gmail.com */
+#ifndef __TASK_TABLE_H_
+#define __TASK_TABLE_H_
+
+#include "vector.h"
+
+#define TASK_TABLE_INDEX_BITS 20
+#define TASK_TABLE_INDEX_MASK ((1u << TASK_TABLE_INDEX_BITS) - 1)
+#define TASK_TABLE_MAX_SLOTS TASK_TABLE_INDEX_MASK
+#define TASK_TABLE_INITIAL_BUCKETS 16
+#define TASK_TABLE_LOAD_FACTOR 0.5
+#define INVALID_HANDLE 0u
+
+/** handle to an entry of the task table. The low bits keep the index of
+ * the slot and the high bits keep the generation of the slot, so that a
+ * handle to a removed entry is never confused with a newer one.
+ */
+typedef unsigned int task_handle_t;
+
+/** structure used to keep an entry of the task table.
+ * key = key of the entry (the id of the task)
+ * value = value stored in the entry
+ * generation = incremented each time the slot is reused
+ * used = whether the slot keeps an entry or not
+ */
+typedef struct {
+	unsigned long key;
+	void *value;
+	unsigned int generation;
+	int used;
+} task_slot_t;
+
+/** structure used to index tasks both by handle and by key.
+ * slots = vector of slots, indexed by the low bits of a handle
+ * free_slots = vector of indexes of unused slots
+ * buckets = open addressing hash table of slot indexes (+1, 0 = empty)
+ * num_buckets = number of buckets, always a power of 2
+ * size = number of entries in the table
+ */
+typedef struct {
+	vector_t *slots;
+	vector_t *free_slots;
+	size_t *buckets;
+	size_t num_buckets;
+	size_t size;
+} task_table_t;
+
+/**
+ * Initialize a task table.
+ * @return = task table after initialization or NULL
+ */
+task_table_t *task_table_init(void);
+
+/**
+ * Add an entry in the task table. If the key is already present, the key
+ * will refer the new entry from now on.
+ * t = task table
+ * key = key of the new entry
+ * value = value of the new entry
+ * @return the handle of the new entry or INVALID_HANDLE on error
+ */
+task_handle_t task_table_insert(task_table_t *t, unsigned long key,
+				void *value);
+
+/**
+ * Get the value of an entry by its handle.
+ * t = task table
+ * handle = handle of the entry
+ * @return the value or NULL if the handle is stale
+ */
+void *task_table_get(task_table_t *t, task_handle_t handle);
+
+/**
+ * Get the handle of an entry by its key.
+ * t = task table
+ * key = key of the entry
+ * @return the handle or INVALID_HANDLE if the key is not present
+ */
+task_handle_t task_table_find(task_table_t *t, unsigned long key);
+
+/**
+ * Remove an entry from the task table.
+ * t = task table
+ * handle = handle of the entry
+ */
+void task_table_remove(task_table_t *t, task_handle_t handle);
+
+/**
+ * Return the number of entries in the task table.
+ * t = task table
+ * @return the number of entries
+ */
+size_t task_table_size(task_table_t *t);
+
+/**
+ * Free the resources allocated for the task table.
+ * t = task table
+ */
+void task_table_free(task_table_t *t);
+
+#endif /* __TASK_TABLE_H_ */
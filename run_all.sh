@@ -205,6 +205,43 @@ test_fun_array=(                                                      \
         test_sched      "Test IO schedule"                      7   1 \
         test_sched      "Test priorities and IO"                10  1 \
         test_sched      "Test priorities and IO (stress test)"  12  0 \
+        test_sched      "Test yield"                            0   0 \
+        test_sched      "Test set priority"                     0   0 \
+        test_sched      "Test task lookup"                      0   0 \
+        test_sched      "Test join"                             0   0 \
+        test_sched      "Test fork argument"                    0   0 \
+        test_sched      "Test inline tasks"                     0   0 \
+        test_sched      "Test task mutex"                       0   0 \
+        test_sched      "Test task semaphore"                   0   0 \
+        test_sched      "Test task barrier"                     0   0 \
+        test_sched      "Test task read-write lock"             0   0 \
+        test_sched      "Test task channel"                     0   0 \
+        test_sched      "Test task channel batches"             0   0 \
+        test_sched      "Test futures"                          0   0 \
+        test_sched      "Test task graph"                       0   0 \
+        test_sched      "Test parallel loop"                    0   0 \
+        test_sched      "Test kill"                             0   0 \
+        test_sched      "Test budgets"                          0   0 \
+        test_sched      "Test task groups"                      0   0 \
+        test_sched      "Test scheduler instances"              0   0 \
+        test_sched      "Test process tasks"                    0   0 \
+        test_sched      "Test cpu affinity"                     0   0 \
+        test_sched      "Test task migration"                   0   0 \
+        test_sched      "Test load balancing"                   0   0 \
+        test_sched      "Test gang groups"                      0   0 \
+        test_sched      "Test wake affine"                      0   0 \
+        test_sched      "Test quanta"                           0   0 \
+        test_sched      "Test adaptive quantum"                 0   0 \
+        test_sched      "Test carry over"                       0   0 \
+        test_sched      "Test kill in sync objects"             0   0 \
+        test_sched      "Test gang rotation"                    0   0 \
+        test_sched      "Test sync objects of a scheduler"      0   0 \
+        test_sched      "Test kill in a task graph"             0   0 \
+        test_sched      "Test kill with adaptive quantum"       0   0 \
+        test_sched      "Test task mutex across groups"         0   0 \
+        test_sched      "Test inline ids across schedulers"     0   0 \
+        test_sched      "Test auto-scaling"                     0   0 \
+        test_sched      "Test signal order"                     0   0 \
 )
 
 last_test=$((${#test_fun_array[@]} / 4))
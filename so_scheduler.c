@@ -1,26 +1,468 @@
 #include "so_scheduler.h"
+#include "so_sched_internal.h"
 #include "utils.h"
 #include "comparators.h"
 #include <string.h>
+#include <setjmp.h>
 
-static so_scheduler_t so_scheduler;
-static unsigned long timestamp;
+/** the scheduler used by the legacy API and the one used by each thread.
+ * The threads of the tasks use the scheduler of their tasks, the other
+ * ones the default scheduler, unless they choose another with so_sched_use.
+ */
+static so_scheduler_t default_scheduler;
+static SO_THREAD_LOCAL so_scheduler_t *current_scheduler;
 
-/* reschedule function after round robin algorithm */
-static void reschedule(void)
+/* the calls a process task forwards to the thread running it */
+enum {
+	SO_PROCESS_EXEC,
+	SO_PROCESS_YIELD,
+	SO_PROCESS_WAIT,
+	SO_PROCESS_SIGNAL
+};
+
+/* set only in the process of a process task, see run_process */
+static so_process_call_t *process_call;
+
+/* ids given to inline tasks, shared by all the schedulers so that a tid
+ * names one task in the whole process
+ */
+static unsigned long num_inline_tids;
+
+static so_thread_t *reschedule(void);
+static int forward_call(unsigned int call, unsigned int arg);
+
+/** get the scheduler of the calling thread. The process of a process task
+ * has only a copy of the scheduler, so it may use just the calls it
+ * forwards.
+ */
+static so_scheduler_t *get_scheduler(void)
+{
+	DIE(process_call != NULL, "call not supported in a process task");
+	if (current_scheduler == NULL)
+		return &default_scheduler;
+	return current_scheduler;
+}
+
+/* keep track of the position of a thread inside the priority queue */
+static void set_so_thread_index(void *elem, size_t index)
+{
+	(*(so_thread_t **) elem)->pq_index = index;
+}
+
+/* initialize a queue of threads ordered by priority */
+priority_queue_t *so_sched_queue_init(void)
+{
+	priority_queue_t *pq;
+
+	pq = priority_queue_init(sizeof(so_thread_t *), compare_so_threads, NULL);
+	DIE(pq == NULL, "priority queue init failed");
+	priority_queue_index_function(pq, set_so_thread_index);
+	return pq;
+}
+
+/* add a thread in a queue of threads */
+void so_sched_enqueue(priority_queue_t *pq, so_thread_t *so_thread)
+{
+	so_thread->queue = pq;
+	priority_queue_push(pq, &so_thread);
+}
+
+/* remove the first thread from a queue of threads */
+so_thread_t *so_sched_dequeue(priority_queue_t *pq)
+{
+	so_thread_t *so_thread;
+
+	so_thread = *(so_thread_t **) priority_queue_top(pq);
+	priority_queue_pop(pq);
+	so_thread->queue = NULL;
+	return so_thread;
+}
+
+/* add a thread in the ready queue of its group */
+static void add_ready(so_thread_t *so_thread)
+{
+	so_thread->queue = so_thread->group->ready;
+	task_group_push(so_thread->group, &so_thread);
+}
+
+/* remove a thread from the ready queue of its group */
+static void remove_ready(so_thread_t *so_thread)
+{
+	task_group_remove(so_thread->group, so_thread->pq_index);
+	so_thread->queue = NULL;
+}
+
+/** get the ready thread which should run next: the first one of the group
+ * chosen by the shares of the groups
+ */
+static so_thread_t *peek_ready(void)
+{
+	so_scheduler_t *sched = get_scheduler();
+	task_group_t *group;
+
+	group = task_group_pick(sched->root_group, sched->clock);
+	if (group == NULL)
+		return NULL;
+	return *(so_thread_t **) priority_queue_top(group->ready);
+}
+
+/** get the ready thread of a gang which has waited the longest since it
+ * last ran, so the threads of the gang take turns whatever their
+ * priorities. Threads which have not run yet go in priority order.
+ */
+static so_thread_t *gang_turn(task_group_t *group)
+{
+	so_thread_t *best = NULL;
+	so_thread_t *other;
+	size_t i;
+
+	for (i = 0; i < priority_queue_size(group->ready); i++) {
+		other = *(so_thread_t **) priority_queue_get(group->ready, i);
+		if (best == NULL || other->last_run < best->last_run ||
+			(other->last_run == best->last_run &&
+			compare_so_threads(&other, &best) < 0))
+			best = other;
+	}
+	return best;
+}
+
+/** take the ready thread which should run next. Once a gang group is
+ * chosen, each of its ready threads gets a quantum, one after another,
+ * before any other group is chosen.
+ */
+static so_thread_t *next_ready(void)
+{
+	so_scheduler_t *sched = get_scheduler();
+	task_group_t *group;
+	so_thread_t *so_thread;
+
+	group = sched->gang;
+	if (group == NULL || sched->gang_turns == 0 ||
+		priority_queue_empty(group->ready) ||
+		task_group_throttled(group, sched->clock)) {
+		group = task_group_pick(sched->root_group, sched->clock);
+		sched->gang = NULL;
+		if (group->gang == TRUE) {
+			sched->gang = group;
+			sched->gang_turns = priority_queue_size(group->ready);
+		}
+	}
+	if (sched->gang != NULL) {
+		sched->gang_turns--;
+		so_thread = gang_turn(group);
+	} else {
+		so_thread = *(so_thread_t **) priority_queue_top(group->ready);
+	}
+	remove_ready(so_thread);
+	return so_thread;
+}
+
+/* bind a synchronization object to the scheduler of its first user */
+int so_sched_bind(struct so_scheduler **owner)
+{
+	so_scheduler_t *sched = get_scheduler();
+	so_scheduler_t *bound;
+
+	bound = __sync_val_compare_and_swap(owner, NULL, sched);
+	return bound == NULL || bound == sched ? SO_SUCCESS : SO_FAILURE;
+}
+
+/* make a waiting thread ready and add it at the end of its priority */
+void so_sched_wake(so_thread_t *so_thread)
+{
+	so_scheduler_t *sched = get_scheduler();
+
+	so_thread->status = READY;
+	so_thread->thread_timestamp = ++sched->timestamp;
+	so_thread->wait_cleanup = NULL;
+	so_thread->wait_object = NULL;
+	add_ready(so_thread);
+}
+
+/* wake a thread with a function to run if it is cancelled before running */
+void so_sched_wake_cleanup(so_thread_t *so_thread, so_wait_cleanup_t cleanup,
+		void *object)
+{
+	so_sched_wake(so_thread);
+	so_thread->wait_cleanup = cleanup;
+	so_thread->wait_object = object;
+}
+
+/* mark the running thread as waiting in a queue of threads */
+void so_sched_park(priority_queue_t *pq)
+{
+	so_scheduler_t *sched = get_scheduler();
+
+	sched->running_thread->status = WAITING;
+	sched->running_thread->thread_timestamp = ++sched->timestamp;
+	so_sched_enqueue(pq, sched->running_thread);
+}
+
+/* park the running thread with a function to run if it is cancelled */
+void so_sched_park_cleanup(priority_queue_t *pq, so_wait_cleanup_t cleanup,
+		void *object)
+{
+	so_scheduler_t *sched = get_scheduler();
+
+	sched->running_thread->wait_cleanup = cleanup;
+	sched->running_thread->wait_object = object;
+	so_sched_park(pq);
+}
+
+/** recompute the priority of a thread as the maximum between the priority
+ * given by the user and the priorities of the threads waiting for its
+ * mutexes. The change is propagated to the owner of the mutex the thread
+ * is waiting for, if any.
+ */
+void so_sched_update_priority(so_thread_t *so_thread)
+{
+	so_task_mutex_t *mutex;
+	so_thread_t *waiter;
+	unsigned int priority;
+
+	while (so_thread != NULL) {
+		priority = so_thread->base_priority;
+		for (mutex = so_thread->owned_mutexes; mutex != NULL;
+				mutex = mutex->next_owned) {
+			if (priority_queue_empty(mutex->waiters))
+				continue;
+			waiter = *(so_thread_t **)
+					priority_queue_top(mutex->waiters);
+			if (waiter->arg.priority > priority)
+				priority = waiter->arg.priority;
+		}
+
+		if (priority == so_thread->arg.priority)
+			break;
+
+		/* keep the queue holding the thread ordered */
+		so_thread->arg.priority = priority;
+		if (so_thread->queue != NULL)
+			priority_queue_update(so_thread->queue,
+					so_thread->pq_index);
+
+		if (so_thread->blocked_on == NULL)
+			break;
+		so_thread = so_thread->blocked_on->owner;
+	}
+}
+
+/** spend a time unit of a thread. Besides its quantum, the unit is taken
+ * from its budget, which is checked by reschedule, and from the shares of
+ * its groups.
+ */
+static void spend_time(so_thread_t *so_thread)
+{
+	so_scheduler_t *sched = get_scheduler();
+
+	so_thread->remaining_time--;
+	so_thread->used_time++;
+	task_group_charge(so_thread->group, ++sched->clock);
+}
+
+/* lock the scheduler and spend time for the running thread */
+so_thread_t *so_sched_enter(void)
+{
+	so_scheduler_t *sched = get_scheduler();
+
+	LOCK(sched);
+	DIE(sched->running_thread == NULL, "no thread running");
+	spend_time(sched->running_thread);
+	return sched->running_thread;
+}
+
+/* unlock the scheduler and let it choose the next thread */
+void so_sched_leave(void)
+{
+	so_scheduler_t *sched = get_scheduler();
+
+	UNLOCK(sched);
+	reschedule();
+}
+
+/* search a thread by its id */
+static so_thread_t *find_thread(tid_t tid)
+{
+	so_scheduler_t *sched = get_scheduler();
+	task_handle_t handle;
+
+	handle = task_table_find(sched->tasks, TID_KEY(tid));
+	return (so_thread_t *) task_table_get(sched->tasks, handle);
+}
+
+void *so_start_thread(void *arg);
+
+/** leave the handler of a cancelled thread, if it is the caller. The thread
+ * is terminated by run_thread, unless so_kill has already done it.
+ */
+static void test_cancel(so_thread_t *so_thread)
+{
+	if (so_thread->cancelled == FALSE || so_thread->exit_point == NULL)
+		return;
+
+	if (!so_equal_threads(so_thread->thread, so_thread_self()))
+		return;
+
+	longjmp(*so_thread->exit_point, 1);
+}
+
+/** give a thread about to be added to the ready queue of its group a
+ * timestamp before the ready threads with its priority, so it is the
+ * first of them to run
+ */
+static void place_first(so_thread_t *so_thread)
+{
+	priority_queue_t *ready = so_thread->group->ready;
+	so_thread_t *other;
+	unsigned long first = 0;
+	SO_BOOL found = FALSE;
+	size_t i;
+
+	for (i = 0; i < priority_queue_size(ready); i++) {
+		other = *(so_thread_t **) priority_queue_get(ready, i);
+		if (other->arg.priority != so_thread->arg.priority)
+			continue;
+		if (found == FALSE || other->thread_timestamp < first)
+			first = other->thread_timestamp;
+		found = TRUE;
+	}
+	if (found == TRUE && first > 0)
+		so_thread->thread_timestamp = first - 1;
+}
+
+/* quantum a thread gets each time it is scheduled, by its priority */
+static unsigned int quantum(so_thread_t *so_thread)
+{
+	if (so_thread->sched->adapt_target != 0)
+		return so_thread->sched->adapt_quantum;
+	return so_thread->sched->q_time[so_thread->arg.priority];
+}
+
+/** account a switch which ended now for the adaptive quantum. At the end
+ * of a window, the quantum is doubled if the switches took more than the
+ * target part of the time, so there are less of them, or halved if they
+ * took less than half of it, so the waiting threads are run sooner.
+ */
+static void adapt_quantum(so_scheduler_t *sched, unsigned long long now)
+{
+	unsigned long long elapsed;
+	unsigned long long overhead;
+
+	if (sched->adapt_target == 0)
+		return;
+
+	sched->switch_ns += now - sched->switch_start;
+	if (++sched->adapt_switches < SO_ADAPT_WINDOW)
+		return;
+
+	elapsed = now - sched->window_start;
+	if (elapsed != 0) {
+		overhead = sched->switch_ns * 100 / elapsed;
+		if (overhead > sched->adapt_target)
+			sched->adapt_quantum = sched->adapt_quantum * 2 >
+				sched->adapt_max ? sched->adapt_max :
+				sched->adapt_quantum * 2;
+		else if (overhead * 2 < sched->adapt_target)
+			sched->adapt_quantum = sched->adapt_quantum / 2 <
+				sched->adapt_min ? sched->adapt_min :
+				sched->adapt_quantum / 2;
+	}
+
+	sched->adapt_switches = 0;
+	sched->switch_ns = 0;
+	sched->window_start = now;
+}
+
+/** apply the budget action of the running thread once it has spent all
+ * its budget. A cancelled thread leaves its handler at the end of the
+ * current reschedule.
+ */
+static void check_budget(so_thread_t *so_thread)
+{
+	if (so_thread->arg.budget == 0 || so_thread->budget_exceeded == TRUE ||
+		so_thread->used_time < so_thread->arg.budget)
+		return;
+
+	so_thread->budget_exceeded = TRUE;
+	switch (so_thread->arg.budget_action) {
+	case SO_BUDGET_DEMOTE:
+		so_thread->base_priority = SO_MIN_PRIORITY;
+		so_sched_update_priority(so_thread);
+		break;
+	case SO_BUDGET_CANCEL:
+		so_thread->cancelled = TRUE;
+		break;
+	default:
+		break;
+	}
+}
+
+/** create the thread running a task, pinned to the cpu of its scheduler
+ * if one was chosen
+ * @return TRUE or FALSE if the thread cannot be created or pinned
+ */
+static SO_BOOL create_context(so_thread_t *so_thread)
 {
+	return so_create_thread_on(&so_thread->thread, so_start_thread,
+			so_thread, so_thread->sched->cpu);
+}
+
+/** mark a thread as the running one and wake it up.
+ * A thread forked with SO_TASK_INLINE has no context until it is first
+ * dispatched. If the caller is a thread which has just terminated, its
+ * context is free, so the new thread is returned to be run inline by the
+ * caller. Otherwise, a context is created for it.
+ */
+static so_thread_t *dispatch(so_thread_t *so_thread, SO_BOOL run_inline)
+{
+	so_scheduler_t *sched = so_thread->sched;
+
+	sched->running_thread = so_thread;
+	so_thread->status = RUNNING;
+	so_thread->last_run = sched->clock;
+	so_thread->wait_cleanup = NULL;
+	so_thread->wait_object = NULL;
+
+	if (so_thread->has_context == FALSE) {
+		so_thread->has_context = TRUE;
+		if (run_inline == TRUE)
+			return so_thread;
+
+		so_thread->own_context = TRUE;
+
+		/* an inline thread has no caller to report a failed pin to */
+		if (create_context(so_thread) == FALSE)
+			DIE(so_create_thread(&so_thread->thread,
+				so_start_thread, so_thread) == FALSE,
+				"thread create failed");
+	}
+
+	if (sched->adapt_target != 0)
+		sched->switch_start = so_time_ns();
+	SCHEDULE_THREAD(so_thread);
+	return NULL;
+}
+
+/** reschedule function after round robin algorithm
+ * @return a thread that should be run inline by the caller or NULL
+ */
+static so_thread_t *reschedule(void)
+{
+	so_scheduler_t *sched = get_scheduler();
 	so_thread_t *running_thread;
-	so_thread_t **front_thread_adddress;
 	so_thread_t *front_thread;
 	so_thread_t *preempted_thread = NULL;
-	priority_queue_t *pq;
+	so_thread_t *inline_thread = NULL;
+	unsigned long long now;
 	size_t pq_size;
 
-	LOCK(so_scheduler);
+	LOCK(sched);
+
+	running_thread = sched->running_thread;
+	if (running_thread != NULL && running_thread->status == RUNNING)
+		check_budget(running_thread);
 
-	running_thread = so_scheduler.running_thread;
-	pq = so_scheduler.pq;
-	pq_size = priority_queue_size(pq);
+	pq_size = sched->root_group->nr_ready;
 
 	/** if one of the following 2 condition happen:
 	 * 1. no thread is running
@@ -30,22 +472,16 @@ static void reschedule(void)
 	 */
 	if (running_thread == NULL || running_thread->status == TERMINATED) {
 		if (pq_size == 0) {
-			if (so_scheduler.num_active_threads == 0) {
-				so_condition_notify(&so_scheduler.finish_cond);
-				UNLOCK(so_scheduler);
-				return;
+			if (sched->num_active_threads == 0) {
+				so_condition_notify(&sched->finish_cond);
+				UNLOCK(sched);
+				return NULL;
 			}
-			so_scheduler.running_thread = NULL;
+			sched->running_thread = NULL;
 		} else {
-			front_thread_adddress =
-					(so_thread_t **) priority_queue_top(pq);
-
-			front_thread = *front_thread_adddress;
-			priority_queue_pop(pq);
-			running_thread = front_thread;
-			so_scheduler.running_thread = front_thread;
-			so_scheduler.running_thread->status = RUNNING;
-			SCHEDULE_THREAD(running_thread);
+			front_thread = next_ready();
+			inline_thread = dispatch(front_thread,
+					running_thread != NULL);
 		}
 		/** if running thread is waiting for a I/O device,
 		 *  it needs to be preempted and other thread should run
@@ -53,115 +489,143 @@ static void reschedule(void)
 		 *  to the priority queue.
 		 */
 	} else if (running_thread->status == WAITING) {
-		preempted_thread = so_scheduler.running_thread;
+		/** a thread which spent its last unit on the call that made it
+		 * wait starts a new quantum, as it would underflow when woken
+		 */
+		preempted_thread = sched->running_thread;
+		if (preempted_thread->remaining_time == 0)
+			preempted_thread->remaining_time =
+				quantum(preempted_thread);
 		if (pq_size == 0)
-			so_scheduler.running_thread = NULL;
+			sched->running_thread = NULL;
 		else {
-			front_thread_adddress =
-					(so_thread_t **)priority_queue_top(pq);
-			front_thread = *front_thread_adddress;
-			priority_queue_pop(pq);
-			running_thread = front_thread;
-			so_scheduler.running_thread = front_thread;
-			so_scheduler.running_thread->status = RUNNING;
-			SCHEDULE_THREAD(running_thread);
+			front_thread = next_ready();
+			dispatch(front_thread, FALSE);
 		}
-		/** if the first two if clauses weren't matched, then
-		 * the thread status is ready and its quantum has finished.
-		 * If there is a best option, preempt this thread and schedule
-		 * the other one. Otherwise, reset the time quantum for this
-		 * thread
+		/** if the first two if clauses weren't matched, then the thread
+		 * is still running. When its quantum has finished or its group
+		 * has run its quota, it goes back in the ready queue of its
+		 * group at the end of its priority and the next thread is
+		 * chosen, which may be itself. Before that, it is preempted only
+		 * by a thread with a higher priority from its own group, as the
+		 * other groups take turns by their shares, and not at all during
+		 * the turn of a gang.
 		 */
-	} else {
-		if (pq_size == 0) {
-			if (running_thread->remaining_time == 0) {
-				running_thread->remaining_time =
-							so_scheduler.q_time;
-
-				running_thread->thread_timestamp =
-							++timestamp;
-			}
-		} else {
-			front_thread_adddress =
-					(so_thread_t **) priority_queue_top(pq);
-
-			front_thread = *front_thread_adddress;
-			if ((running_thread->remaining_time == 0 &&
-				running_thread->arg.priority ==
-				front_thread->arg.priority) ||
-
-				(running_thread->arg.priority <
-				front_thread->arg.priority)) {
+	} else if (running_thread->remaining_time == 0 ||
+		task_group_throttled(running_thread->group,
+			sched->clock)) {
+		running_thread->remaining_time = quantum(running_thread);
+		running_thread->thread_timestamp = ++sched->timestamp;
+		running_thread->status = READY;
+		add_ready(running_thread);
 
-				priority_queue_pop(pq);
-				preempted_thread = running_thread;
+		front_thread = next_ready();
+		if (front_thread == running_thread)
+			running_thread->status = RUNNING;
+		else {
+			preempted_thread = running_thread;
+			dispatch(front_thread, FALSE);
+		}
+	} else if (pq_size != 0) {
+		front_thread = peek_ready();
+		if (front_thread->group == running_thread->group &&
+			running_thread->group != sched->gang &&
+			running_thread->arg.priority <
+			front_thread->arg.priority) {
+			remove_ready(front_thread);
+			preempted_thread = running_thread;
+			preempted_thread->thread_timestamp = ++sched->timestamp;
+			if (sched->carry_over == TRUE)
+				place_first(preempted_thread);
+			else
 				preempted_thread->remaining_time =
-						so_scheduler.q_time;
-				preempted_thread->thread_timestamp =
-						++timestamp;
-
-				preempted_thread->status = READY;
-				priority_queue_push(pq, &preempted_thread);
-				running_thread = front_thread;
-				so_scheduler.running_thread = front_thread;
-				so_scheduler.running_thread->status = RUNNING;
-				SCHEDULE_THREAD(running_thread);
-			} else if (
-				running_thread->remaining_time == 0) {
-				running_thread->remaining_time =
-						so_scheduler.q_time;
-			}
+					quantum(preempted_thread);
+			preempted_thread->status = READY;
+			add_ready(preempted_thread);
+			dispatch(front_thread, FALSE);
 		}
 	}
 
-	UNLOCK(so_scheduler);
-	if (preempted_thread)
+	UNLOCK(sched);
+	if (preempted_thread) {
 		WAIT_FOR_SCHEDULE(preempted_thread);
+
+		/** the thread may have been moved to another scheduler. Only
+		 * a dispatch ends a switch: a thread woken by cancel_thread
+		 * is already terminated and leaves without locking the
+		 * scheduler, which may be ending.
+		 */
+		current_scheduler = preempted_thread->sched;
+		if (preempted_thread->status != TERMINATED &&
+			current_scheduler->adapt_target != 0) {
+			now = so_time_ns();
+			LOCK(current_scheduler);
+			adapt_quantum(current_scheduler, now);
+			UNLOCK(current_scheduler);
+		}
+	}
+
+	/* every call to the scheduler is a cancellation point */
+	if (running_thread != NULL)
+		test_cancel(running_thread);
+	return inline_thread;
 }
 
-int so_init(unsigned int q_time, unsigned int num_io_dev)
+/* initialize the state of a scheduler */
+static int init_scheduler(so_scheduler_t *sched, unsigned int q_time,
+		unsigned int num_io_dev)
 {
 	int rc;
 	size_t i;
 
 	/* check the valid condition for an initialization */
-	if (so_scheduler.initialized == TRUE ||
+	if (sched->initialized == TRUE ||
 		q_time == 0 ||
 		num_io_dev > SO_MAX_DEVICE)
 		return SO_FAILURE;
 
-	timestamp = 0;
-	so_scheduler.num_io_devices = num_io_dev;
-	so_scheduler.q_time = q_time;
-	so_scheduler.initialized = TRUE;
-	so_scheduler.num_active_threads = 0;
-	so_scheduler.running_thread = NULL;
+	sched->timestamp = 0;
+	sched->num_io_devices = num_io_dev;
+	for (i = 0; i <= SO_MAX_PRIORITY; i++)
+		sched->q_time[i] = q_time;
+	sched->initialized = TRUE;
+	sched->num_active_threads = 0;
+	sched->running_thread = NULL;
+	sched->cpu = -1;
 
 	/* initialize the syncronizing mechanism */
-	rc = so_mutex_init(&so_scheduler.lock);
+	rc = so_mutex_init(&sched->lock);
 	DIE(rc != TRUE, "mutex init failed");
 
-	rc = so_condition_init(&so_scheduler.finish_cond);
+	rc = so_condition_init(&sched->finish_cond);
 	DIE(rc != TRUE, "condition init failed");
 
 	/* initialize the data structures for the scheduler */
-	so_scheduler.pq =
-		priority_queue_init(
-			sizeof(so_thread_t),
-			compare_so_threads,
-			NULL);
+	sched->clock = 0;
+	sched->gang = NULL;
+	sched->gang_turns = 0;
+	sched->wake_affine = FALSE;
+	sched->adapt_target = 0;
+	sched->carry_over = FALSE;
+	sched->root_group = task_group_init(NULL,
+			TASK_GROUP_DEFAULT_WEIGHT, so_sched_queue_init());
+	DIE(sched->root_group == NULL, "task group init failed");
 
-	so_scheduler.terminated_threads =
+	sched->terminated_threads =
 				vector_init(sizeof(so_thread_t *));
 
+	sched->tasks = task_table_init();
+	DIE(sched->tasks == NULL, "task table init failed");
+
 	for (i = 0; i < num_io_dev; ++i)
-		so_scheduler.waiting_threads_io[i] =
-				vector_init(sizeof(so_thread_t));
+		sched->waiting_threads_io[i] =
+				vector_init(sizeof(so_thread_t *));
 
 	return SO_SUCCESS;
 }
 
-void so_end(void)
+/* wait for the tasks of a scheduler to finish and release its state */
+static void end_scheduler(so_scheduler_t *sched)
 {
 	so_cond_t *so_cond;
 	so_mutex_t *so_mutex;
@@ -171,70 +635,189 @@ void so_end(void)
 	size_t i;
 
 	/* check if the so_init was called before */
-	if (so_scheduler.initialized == FALSE)
+	if (sched->initialized == FALSE)
 		return;
 
-	so_cond = &so_scheduler.finish_cond;
-	so_mutex = &so_scheduler.lock;
-	so_vector = so_scheduler.terminated_threads;
+	so_cond = &sched->finish_cond;
+	so_mutex = &sched->lock;
+	so_vector = sched->terminated_threads;
 
-	LOCK(so_scheduler);
+	LOCK(sched);
 	/* if there are still active threads, wait for them to finish */
-	while (so_scheduler.num_active_threads > 0)
+	while (sched->num_active_threads > 0)
 		so_condition_wait(so_cond, so_mutex);
 
 	/* release the data structure and syncronization mechanism used */
-	priority_queue_free(so_scheduler.pq);
+	task_group_free_all(sched->root_group);
 	v_size = vector_size(so_vector);
 	for (i = 0; i < v_size; ++i) {
 		thread_obj =
 			(so_thread_t **) vector_get_back(so_vector);
-		so_join_thread((*thread_obj)->thread);
+		if ((*thread_obj)->own_context == TRUE)
+			so_join_thread((*thread_obj)->thread);
 		so_semaphore_destroy(&(*thread_obj)->preempted);
+		task_table_remove(sched->tasks, (*thread_obj)->handle);
 		free(*thread_obj);
 		vector_pop_back(so_vector);
 	}
 
-	free_vector(so_scheduler.terminated_threads);
-	so_mutex_destroy(&so_scheduler.lock);
+	free_vector(sched->terminated_threads);
+	task_table_free(sched->tasks);
+	so_mutex_destroy(&sched->lock);
 
-	for (i = 0; i < so_scheduler.num_io_devices; ++i)
-		free_vector(so_scheduler.waiting_threads_io[i]);
+	for (i = 0; i < sched->num_io_devices; ++i)
+		free_vector(sched->waiting_threads_io[i]);
 
-	UNLOCK(so_scheduler);
+	UNLOCK(sched);
 
 	/* mark the scheduler as unitialized */
-	so_scheduler.initialized = FALSE;
+	sched->initialized = FALSE;
+
+}
+
+int so_init(unsigned int q_time, unsigned int num_io_dev)
+{
+	return init_scheduler(&default_scheduler, q_time, num_io_dev);
+}
+
+int so_init_quanta(const unsigned int *q_times, unsigned int num_io_dev)
+{
+	unsigned int i;
+
+	if (q_times == NULL)
+		return SO_FAILURE;
+	for (i = 0; i <= SO_MAX_PRIORITY; i++)
+		if (q_times[i] == 0)
+			return SO_FAILURE;
+
+	if (init_scheduler(&default_scheduler, q_times[0],
+			num_io_dev) != SO_SUCCESS)
+		return SO_FAILURE;
+
+	for (i = 0; i <= SO_MAX_PRIORITY; i++)
+		default_scheduler.q_time[i] = q_times[i];
+	return SO_SUCCESS;
+}
+
+void so_end(void)
+{
+	end_scheduler(&default_scheduler);
+}
+
+so_sched_t *so_sched_create(unsigned int q_time, unsigned int num_io_dev)
+{
+	so_scheduler_t *sched;
+
+	sched = calloc(1, sizeof(so_scheduler_t));
+	if (sched == NULL)
+		return NULL;
+
+	if (init_scheduler(sched, q_time, num_io_dev) != SO_SUCCESS) {
+		free(sched);
+		return NULL;
+	}
+	return sched;
+}
+
+void so_sched_destroy(so_sched_t *sched)
+{
+	/* the default scheduler is released only by so_end */
+	if (sched == NULL || sched == &default_scheduler)
+		return;
 
+	end_scheduler(sched);
+	if (current_scheduler == sched)
+		current_scheduler = NULL;
+	free(sched);
+}
+
+so_sched_t *so_sched_use(so_sched_t *sched)
+{
+	so_scheduler_t *previous;
+	SO_BOOL is_task = FALSE;
+
+	previous = get_scheduler();
+
+	/** a task may call the API only while it is the running thread of
+	 * its scheduler, which owns its so_thread, so it cannot leave it
+	 */
+	if (previous->initialized == TRUE) {
+		LOCK(previous);
+		is_task = previous->running_thread != NULL &&
+			so_equal_threads(previous->running_thread->thread,
+				so_thread_self());
+		UNLOCK(previous);
+	}
+	if (is_task == TRUE &&
+		(sched == NULL ? &default_scheduler : sched) != previous)
+		return NULL;
+
+	current_scheduler = sched;
+	return previous;
 }
 
 void so_exec(void)
 {
+	so_scheduler_t *sched;
 	so_thread_t *current_thread;
 
+	/* a process task forwards the call to the thread running it */
+	if (process_call != NULL) {
+		forward_call(SO_PROCESS_EXEC, 0);
+		return;
+	}
+	sched = get_scheduler();
+
 	/* check if there is a thread created by so_fork that is running */
-	DIE(so_scheduler.running_thread == NULL, "no thread running");
+	DIE(sched->running_thread == NULL, "no thread running");
 
 	/* just spend time on the processor */
-	current_thread = so_scheduler.running_thread;
-	current_thread->remaining_time--;
+	current_thread = sched->running_thread;
+	spend_time(current_thread);
 	reschedule();
 }
 
-int so_wait(unsigned int io_device)
+void so_yield(void)
 {
+	so_scheduler_t *sched;
+	so_thread_t *current_thread;
+
+	if (process_call != NULL) {
+		forward_call(SO_PROCESS_YIELD, 0);
+		return;
+	}
+	sched = get_scheduler();
 
+	/* check if there is a thread created by so_fork that is running */
+	DIE(sched->running_thread == NULL, "no thread running");
+
+	/** give up the rest of the quantum without spending a unit, so that
+	 * reschedule treats it as an expired quantum and sends the thread
+	 * at the back of its priority level
+	 */
+	current_thread = sched->running_thread;
+	current_thread->remaining_time = 0;
+	reschedule();
+}
+
+int so_wait(unsigned int io_device)
+{
+	so_scheduler_t *sched;
 	so_thread_t *running_thread;
 	SO_BOOL status;
 
+	if (process_call != NULL)
+		return forward_call(SO_PROCESS_WAIT, io_device);
+	sched = get_scheduler();
+
 	running_thread = NULL;
 	status = SO_SUCCESS;
 
-	LOCK(so_scheduler);
-	DIE(so_scheduler.running_thread == NULL, "no thread running");
-	running_thread = so_scheduler.running_thread;
-	running_thread->remaining_time--;
-	if (io_device >= so_scheduler.num_io_devices)
+	LOCK(sched);
+	DIE(sched->running_thread == NULL, "no thread running");
+	running_thread = sched->running_thread;
+	spend_time(running_thread);
+	if (io_device >= sched->num_io_devices)
 		status = SO_FAILURE;
 	else {
 		/** mark current thread as WAITING and add it in
@@ -242,54 +825,87 @@ int so_wait(unsigned int io_device)
 		 */
 		running_thread->status = WAITING;
 		vector_push_back(
-			so_scheduler.waiting_threads_io[io_device],
+			sched->waiting_threads_io[io_device],
 			&running_thread);
 	}
 
-	UNLOCK(so_scheduler);
+	UNLOCK(sched);
 	reschedule();
 	return status;
 }
 
+/** make the threads waiting for a device ready, in the order they started
+ * to wait in, and empty its queue. With wake affine placement on, while
+ * the ready queue of its group is short, a thread goes in front of the
+ * threads with its priority, to run right after the signalling thread,
+ * while the data that thread left is still in the cache. Only the first
+ * SO_WAKE_AFFINE_MAX threads woken are placed so, not to hold back the
+ * other ready threads too long, and they are placed from the last one, so
+ * they keep their order in front.
+ * @return the number of threads woken
+ */
+static int wake_waiters(so_scheduler_t *sched, vector_t *waiting)
+{
+	so_thread_t *affine[SO_WAKE_AFFINE_MAX];
+	so_thread_t *so_thread;
+	int num_affine = 0, woken = 0;
+	size_t i;
+
+	for (i = 0; i < vector_size(waiting); i++) {
+		so_thread = *(so_thread_t **) vector_get(waiting, i);
+
+		/* cancelled threads are only dropped from the device */
+		if (so_thread->status == TERMINATED)
+			continue;
+		so_thread->status = READY;
+		so_thread->thread_timestamp = ++sched->timestamp;
+
+		if (sched->wake_affine == TRUE &&
+			woken < SO_WAKE_AFFINE_MAX &&
+			priority_queue_size(so_thread->group->ready) <
+			SO_WAKE_AFFINE_QUEUE)
+			affine[num_affine++] = so_thread;
+		else
+			add_ready(so_thread);
+		woken++;
+	}
+
+	while (num_affine > 0) {
+		so_thread = affine[--num_affine];
+		place_first(so_thread);
+		add_ready(so_thread);
+	}
+
+	while (!vector_empty(waiting))
+		vector_pop_back(waiting);
+	return woken;
+}
+
 int so_signal(unsigned int io_device)
 {
-	int i, num_threads_signal = 0;
-	so_thread_t **last_thread_address;
-	so_thread_t *last_thread;
+	so_scheduler_t *sched;
+	int num_threads_signal = 0;
 	so_thread_t *running_thread;
 	SO_BOOL status = SO_SUCCESS;
 
-	LOCK(so_scheduler);
-	DIE(so_scheduler.running_thread == NULL, "no thread running");
+	if (process_call != NULL)
+		return forward_call(SO_PROCESS_SIGNAL, io_device);
+	sched = get_scheduler();
+
+	LOCK(sched);
+	DIE(sched->running_thread == NULL, "no thread running");
 
-	running_thread = so_scheduler.running_thread;
-	running_thread->remaining_time--;
+	running_thread = sched->running_thread;
+	spend_time(running_thread);
 
 	/* check if the device is supported by the scheduler */
-	if (io_device >= so_scheduler.num_io_devices)
+	if (io_device >= sched->num_io_devices)
 		status = SO_FAILURE;
-	else {
-		/** add all the waiting threads on that I/O device
-		 * to the priority queue and mark them as READY.
-		 */
-		num_threads_signal =
-			vector_size(
-				so_scheduler.waiting_threads_io[io_device]);
-		for (i = 0; i < num_threads_signal; ++i) {
-			last_thread_address =
-				(so_thread_t **)
-				vector_get_back(
-				so_scheduler.waiting_threads_io[io_device]);
-			vector_pop_back(
-				so_scheduler.waiting_threads_io[io_device]);
-			last_thread = *last_thread_address;
-			last_thread->status = READY;
-			last_thread->thread_timestamp = ++timestamp;
-			priority_queue_push(so_scheduler.pq, &last_thread);
-		}
-	}
+	else
+		num_threads_signal = wake_waiters(sched,
+				sched->waiting_threads_io[io_device]);
 
-	UNLOCK(so_scheduler);
+	UNLOCK(sched);
 	reschedule();
 	if (status == SO_SUCCESS)
 		return num_threads_signal;
@@ -297,84 +913,1163 @@ int so_signal(unsigned int io_device)
 		return SO_FAILURE;
 }
 
-/* thread wrapper function */
-void *so_start_thread(void *arg)
+int so_set_priority(tid_t tid, unsigned int priority)
 {
+	so_scheduler_t *sched = get_scheduler();
 	so_thread_t *so_thread;
-	so_handler handler;
-	int priority;
 
-	so_thread = (so_thread_t *)arg;
-	priority = so_thread->arg.priority;
-	handler = so_thread->arg.handler;
+	/* check if proper parameters were given */
+	if (priority > SO_MAX_PRIORITY)
+		return SO_FAILURE;
 
+	LOCK(sched);
+	so_thread = find_thread(tid);
+	if (so_thread == NULL || so_thread->status == TERMINATED) {
+		UNLOCK(sched);
+		return SO_FAILURE;
+	}
 
-	/* block, so that no action is made until thread is schedule */
-	WAIT_FOR_SCHEDULE(so_thread);
-	so_thread->status = RUNNING;
+	/** a thread in a queue (READY or waiting for a mutex) is moved in
+	 * place, one waiting for I/O will be added with the new priority when
+	 * it is signaled
+	 */
+	so_thread->base_priority = priority;
+	so_sched_update_priority(so_thread);
 
-	/* check the argument is properly received, by checking the priority */
-	DIE(priority > SO_MAX_PRIORITY || priority < SO_MIN_PRIORITY,
-										"so_priority check failed");
-	/* run the function */
-	handler(priority);
-	LOCK(so_scheduler);
+	/* if the priority was changed by a running thread, spend time */
+	if (sched->running_thread != NULL)
+		spend_time(sched->running_thread);
+	UNLOCK(sched);
 
-	/* mark the thread as terminated */
-	so_scheduler.num_active_threads--;
-	so_scheduler.num_terminated_threads++;
-	vector_push_back(so_scheduler.terminated_threads, &so_thread);
-	so_thread->status = TERMINATED;
-	so_thread->remaining_time = 0;
-	DIE(so_scheduler.running_thread->remaining_time != 0,
-											"time not match");
-	DIE(so_scheduler.running_thread->status != TERMINATED,
-											"status not match");
-	UNLOCK(so_scheduler);
+	/* the running thread may not be the best choice anymore */
 	reschedule();
-	return NULL;
+	return SO_SUCCESS;
 }
 
-tid_t so_fork(so_handler handler, unsigned int priority)
+int so_budget_exceeded(tid_t tid)
+{
+	so_scheduler_t *sched = get_scheduler();
+	so_thread_t *so_thread;
+	int exceeded;
+
+	LOCK(sched);
+	so_thread = find_thread(tid);
+	if (so_thread == NULL) {
+		UNLOCK(sched);
+		return SO_FAILURE;
+	}
+
+	exceeded = so_thread->budget_exceeded == TRUE;
+	UNLOCK(sched);
+	return exceeded;
+}
+
+tid_t so_self(void)
+{
+	so_scheduler_t *sched = get_scheduler();
+	so_thread_t *running_thread;
+	tid_t tid = INVALID_TID;
+
+	LOCK(sched);
+	running_thread = sched->running_thread;
+	if (running_thread != NULL &&
+		so_equal_threads(running_thread->thread, so_thread_self()))
+		tid = running_thread->tid;
+	UNLOCK(sched);
+	return tid;
+}
+
+int so_wait_all(const tid_t *tids, unsigned int count)
+{
+	so_scheduler_t *sched = get_scheduler();
+	so_thread_t *running_thread;
+	so_thread_t *so_thread;
+	SO_BOOL status;
+	unsigned int i;
+
+	if (tids == NULL && count > 0)
+		return SO_FAILURE;
+
+	status = SO_SUCCESS;
+
+	LOCK(sched);
+	DIE(sched->running_thread == NULL, "no thread running");
+	running_thread = sched->running_thread;
+	spend_time(running_thread);
+
+	/* check every task exists before waiting for any of them */
+	for (i = 0; i < count && status == SO_SUCCESS; ++i) {
+		so_thread = find_thread(tids[i]);
+		if (so_thread == NULL || so_thread == running_thread)
+			status = SO_FAILURE;
+	}
+
+	/** register the running thread as a joiner of every task that has
+	 * not terminated yet and park it like a thread waiting for I/O
+	 */
+	running_thread->join_pending = 0;
+	for (i = 0; i < count && status == SO_SUCCESS; ++i) {
+		so_thread = find_thread(tids[i]);
+		if (so_thread->status == TERMINATED)
+			continue;
+
+		if (so_thread->joiners == NULL) {
+			so_thread->joiners =
+				vector_init(sizeof(so_thread_t *));
+			DIE(so_thread->joiners == NULL, "vector init failed");
+		}
+		vector_push_back(so_thread->joiners, &running_thread);
+		running_thread->join_pending++;
+	}
+
+	if (running_thread->join_pending > 0)
+		running_thread->status = WAITING;
+
+	UNLOCK(sched);
+	reschedule();
+	if (status == SO_FAILURE)
+		return status;
+
+	/* the tasks stay in the task table until so_end */
+	LOCK(sched);
+	for (i = 0; i < count; ++i) {
+		so_thread = find_thread(tids[i]);
+		if (so_thread != NULL && so_thread->cancelled == TRUE)
+			status = SO_JOIN_CANCELLED;
+	}
+	UNLOCK(sched);
+	return status;
+}
+
+int so_join(tid_t tid)
+{
+	return so_wait_all(&tid, 1);
+}
+
+int so_future_get(so_future_t future, void **result)
+{
+	so_scheduler_t *sched = get_scheduler();
+	so_thread_t *so_thread;
+
+	if (result == NULL || so_join(future) == SO_FAILURE)
+		return SO_FAILURE;
+
+	/* the task stays in the task table until so_end */
+	LOCK(sched);
+	so_thread = find_thread(future);
+	*result = so_thread->result;
+	UNLOCK(sched);
+	return so_thread->cancelled == TRUE ? SO_FAILURE : SO_SUCCESS;
+}
+
+/* wake up the threads which were waiting only for a terminated thread */
+static void release_joiners(so_thread_t *so_thread)
+{
+	so_thread_t *joiner;
+	size_t i;
+
+	if (so_thread->joiners == NULL)
+		return;
+
+	for (i = 0; i < vector_size(so_thread->joiners); ++i) {
+		joiner = *(so_thread_t **) vector_get(so_thread->joiners, i);
+		if (joiner->status == TERMINATED || --joiner->join_pending > 0)
+			continue;
+
+		so_sched_wake(joiner);
+	}
+
+	free_vector(so_thread->joiners);
+	so_thread->joiners = NULL;
+}
+
+/* mark a thread as terminated and release what it holds */
+static void terminate_thread(so_thread_t *so_thread)
+{
+	so_scheduler_t *sched = get_scheduler();
+
+	sched->num_active_threads--;
+	sched->num_terminated_threads++;
+	vector_push_back(sched->terminated_threads, &so_thread);
+	so_thread->status = TERMINATED;
+	so_thread->remaining_time = 0;
+	so_thread->group->nr_tasks--;
+	so_task_mutex_release_all(so_thread);
+	so_task_rwlock_release_all(so_thread);
+	release_joiners(so_thread);
+}
+
+/** terminate a thread which is not running. A thread waiting in a queue is
+ * removed from it, while one waiting for I/O or for other threads is
+ * skipped when it would be woken up. If the thread has a context, it is
+ * woken up to leave its handler.
+ */
+static void cancel_thread(so_thread_t *so_thread)
+{
+	so_thread_t *owner;
+
+	if (so_thread->queue == so_thread->group->ready) {
+		remove_ready(so_thread);
+	} else if (so_thread->queue != NULL) {
+		priority_queue_remove(so_thread->queue, so_thread->pq_index);
+		so_thread->queue = NULL;
+	}
+
+	/** undo what the thread did in the object it was waiting for or give
+	 * back what the object handed it when it was woken up
+	 */
+	if (so_thread->wait_cleanup != NULL) {
+		so_thread->wait_cleanup(so_thread->wait_object);
+		so_thread->wait_cleanup = NULL;
+		so_thread->wait_object = NULL;
+	}
+
+	/* the owner of the mutex may lose the priority lent by the thread */
+	if (so_thread->blocked_on != NULL) {
+		owner = so_thread->blocked_on->owner;
+		so_thread->blocked_on = NULL;
+		so_sched_update_priority(owner);
+	}
+
+	terminate_thread(so_thread);
+	if (so_thread->has_context == TRUE)
+		SCHEDULE_THREAD(so_thread);
+}
+
+int so_kill(tid_t tid)
+{
+	so_scheduler_t *sched = get_scheduler();
+	so_thread_t *so_thread;
+
+	LOCK(sched);
+	so_thread = find_thread(tid);
+	if (so_thread == NULL || so_thread->status == TERMINATED) {
+		UNLOCK(sched);
+		return SO_FAILURE;
+	}
+
+	/* the running thread is terminated at the next scheduling point */
+	so_thread->cancelled = TRUE;
+	if (so_thread != sched->running_thread)
+		cancel_thread(so_thread);
+
+	if (sched->running_thread != NULL)
+		spend_time(sched->running_thread);
+	UNLOCK(sched);
+
+	reschedule();
+	return SO_SUCCESS;
+}
+
+/* run the handler of a thread on the calling thread */
+static void run_handler(so_thread_t *so_thread)
+{
+	if (so_thread->arg.handler != NULL)
+		so_thread->arg.handler(so_thread->arg.priority);
+	else if (so_thread->arg.arg_handler != NULL)
+		so_thread->arg.arg_handler(so_thread->arg.user_arg);
+	else
+		so_thread->result = so_thread->arg.future_handler(
+				so_thread->arg.user_arg);
+}
+
+/* run the handler of a process task, in its own process */
+static void start_process(void *arg)
+{
+	so_thread_t *so_thread;
+
+	so_thread = (so_thread_t *)arg;
+	process_call = so_thread->process;
+	run_handler(so_thread);
+}
+
+/* forward a call of a process task and wait for its result */
+static int forward_call(unsigned int call, unsigned int arg)
+{
+	SO_BOOL rc;
+
+	process_call->call = call;
+	process_call->arg = arg;
+	rc = so_process_notify(&process_call->process);
+	DIE(rc != TRUE, "process notify failed");
+	so_semaphore_acquire(&process_call->reply);
+	return process_call->result;
+}
+
+/** run the handler of a thread in a new process. The thread stays the task
+ * seen by the scheduler and makes the calls forwarded by the process,
+ * until the process exits.
+ */
+static void run_process(so_thread_t *so_thread)
+{
+	so_process_call_t *call;
+	SO_BOOL rc;
+
+	call = so_shared_alloc(sizeof(so_process_call_t));
+	DIE(call == NULL, "shared alloc failed");
+	rc = so_semaphore_init_shared(&call->reply, 0);
+	DIE(rc != TRUE, "semaphore init failed");
+	so_thread->process = call;
+
+	rc = so_create_process(&call->process, start_process, so_thread);
+	DIE(rc != TRUE, "process create failed");
+
+	while (so_process_wait(&call->process) == TRUE) {
+		switch (call->call) {
+		case SO_PROCESS_EXEC:
+			so_exec();
+			break;
+		case SO_PROCESS_YIELD:
+			so_yield();
+			break;
+		case SO_PROCESS_WAIT:
+			call->result = so_wait(call->arg);
+			break;
+		case SO_PROCESS_SIGNAL:
+			call->result = so_signal(call->arg);
+			break;
+		}
+		so_semaphore_release(&call->reply);
+	}
+}
+
+/** kill the process of a thread, if it is still running, and release it.
+ * A process that has not exited by itself, because it crashed or the task
+ * was cancelled, leaves the task marked as cancelled.
+ */
+static void end_process(so_thread_t *so_thread)
+{
+	so_process_call_t *call;
+
+	call = so_thread->process;
+	if (so_process_end(&call->process) == FALSE)
+		so_thread->cancelled = TRUE;
+	so_semaphore_destroy(&call->reply);
+	so_shared_free(call, sizeof(so_process_call_t));
+	so_thread->process = NULL;
+	so_thread->last_run = 0;
+}
+
+/** run the handler of a thread and mark it as terminated
+ * @return the next thread to be run inline or NULL
+ */
+static so_thread_t *run_thread(so_thread_t *so_thread)
+{
+	so_scheduler_t *sched = get_scheduler();
+	jmp_buf exit_point;
+	int priority;
+
+	/* a thread cancelled before it was run has nothing left to do */
+	if (so_thread->status == TERMINATED)
+		return NULL;
+
+	priority = so_thread->arg.priority;
+	so_thread->status = RUNNING;
+
+	/* check the argument is properly received, by checking the priority */
+	DIE(priority > SO_MAX_PRIORITY || priority < SO_MIN_PRIORITY,
+										"so_priority check failed");
+	/* run the function, until it returns or the thread is cancelled */
+	so_thread->exit_point = &exit_point;
+	if (setjmp(exit_point) == 0) {
+		if (so_thread->arg.flags & SO_TASK_PROCESS)
+			run_process(so_thread);
+		else
+			run_handler(so_thread);
+	}
+	so_thread->exit_point = NULL;
+	if (so_thread->process != NULL)
+		end_process(so_thread);
+
+	/* a thread cancelled while it was not running was terminated */
+	if (so_thread->status == TERMINATED)
+		return NULL;
+
+	/* the thread may have been moved to another scheduler meanwhile */
+	sched = get_scheduler();
+	LOCK(sched);
+
+	/* mark the thread as terminated */
+	terminate_thread(so_thread);
+	DIE(sched->running_thread->remaining_time != 0,
+											"time not match");
+	DIE(sched->running_thread->status != TERMINATED,
+											"status not match");
+	UNLOCK(sched);
+	return reschedule();
+}
+
+/* thread wrapper function */
+void *so_start_thread(void *arg)
 {
+	so_thread_t *so_thread;
+
+	so_thread = (so_thread_t *)arg;
+
+	/* block, so that no action is made until thread is schedule */
+	WAIT_FOR_SCHEDULE(so_thread);
+	current_scheduler = so_thread->sched;
+
+	/* keep running the threads handed over when a thread terminates */
+	while (so_thread != NULL) {
+		so_thread->thread = so_thread_self();
+		so_thread = run_thread(so_thread);
+	}
+	return NULL;
+}
 
-	so_thread_arg_t *arg;
+/* creates a thread for the given argument and adds it in the pq */
+static tid_t fork_thread(so_thread_arg_t *thread_arg)
+{
+	so_scheduler_t *sched = get_scheduler();
 	tid_t *thread;
-	priority_queue_t *pq;
 	so_thread_t *so_thread;
 	so_sem_t *thread_sem;
 
-	/* check if proper parameters were given */
-	if (handler == NULL || priority > SO_MAX_PRIORITY)
-		return INVALID_TID;
-
 	so_thread = malloc(sizeof(so_thread_t));
 	DIE(so_thread == NULL, "malloc failed()\n");
 
 	/* initialize argument of the thread */
 	thread = &so_thread->thread;
-	arg = &so_thread->arg;
 	thread_sem = &so_thread->preempted;
-	so_thread->remaining_time = so_scheduler.q_time;
 
 	so_thread->status = NEW;
-	arg->handler = handler;
-	arg->priority = priority;
-	pq = so_scheduler.pq;
+	so_thread->joiners = NULL;
+	so_thread->join_pending = 0;
+	so_thread->arg = *thread_arg;
+	so_thread->base_priority = thread_arg->priority;
+	so_thread->queue = NULL;
+	so_thread->owned_mutexes = NULL;
+	so_thread->blocked_on = NULL;
+	so_thread->num_read_locks = 0;
+	so_thread->written_locks = NULL;
+	so_thread->wait_cleanup = NULL;
+	so_thread->wait_object = NULL;
+	so_thread->wait_data = NULL;
+	so_thread->result = NULL;
+	so_thread->cancelled = FALSE;
+	so_thread->exit_point = NULL;
+	so_thread->used_time = 0;
+	so_thread->budget_exceeded = FALSE;
+	so_thread->sched = sched;
+	so_thread->process = NULL;
 
 	so_semaphore_init(thread_sem, 0);
-	so_create_thread(thread, so_start_thread, so_thread);
+
+	/** an inline thread gets its context only when it is dispatched,
+	 * so it is identified by an odd id, which is never an id of a
+	 * real thread. Until then, the other threads compare their id with
+	 * an invalid one.
+	 */
+	if (thread_arg->flags & SO_TASK_INLINE) {
+		so_thread->has_context = FALSE;
+		so_thread->own_context = FALSE;
+		*thread = INVALID_TID;
+	} else {
+		so_thread->has_context = TRUE;
+		so_thread->own_context = TRUE;
+		if (create_context(so_thread) == FALSE) {
+			so_semaphore_destroy(thread_sem);
+			free(so_thread);
+			return INVALID_TID;
+		}
+		so_thread->tid = *thread;
+	}
 	so_thread->status = READY;
 
-	LOCK(so_scheduler);
+	LOCK(sched);
+	so_thread->remaining_time = quantum(so_thread);
+
 	/* if there was fork in another fork, spend time */
-	if (so_scheduler.running_thread != NULL)
-		so_scheduler.running_thread->remaining_time--;
+	if (sched->running_thread != NULL)
+		spend_time(sched->running_thread);
+
+	if (so_thread->has_context == FALSE)
+		so_thread->tid = (tid_t)
+			(__sync_add_and_fetch(&num_inline_tids, 1) * 2 + 1);
+
+	so_thread->thread_timestamp = ++sched->timestamp;
+	so_thread->handle = task_table_insert(sched->tasks,
+					TID_KEY(so_thread->tid), so_thread);
+	DIE(so_thread->handle == INVALID_HANDLE, "task table insert failed");
+	sched->num_active_threads++;
+
+	/* a task forked by another task stays in the group of its parent */
+	so_thread->group = thread_arg->group;
+	if (so_thread->group == NULL && sched->running_thread != NULL &&
+		so_equal_threads(sched->running_thread->thread,
+			so_thread_self()))
+		so_thread->group = sched->running_thread->group;
+	if (so_thread->group == NULL)
+		so_thread->group = sched->root_group;
+	so_thread->group->nr_tasks++;
+	add_ready(so_thread);
+	UNLOCK(sched);
+	reschedule();
+	return so_thread->tid;
+}
+
+tid_t so_fork(so_handler handler, unsigned int priority)
+{
+	so_thread_arg_t arg;
+
+	/* check if proper parameters were given */
+	if (handler == NULL || priority > SO_MAX_PRIORITY)
+		return INVALID_TID;
+
+	arg.handler = handler;
+	arg.arg_handler = NULL;
+	arg.future_handler = NULL;
+	arg.user_arg = NULL;
+	arg.priority = priority;
+	arg.flags = 0;
+	arg.budget = 0;
+	arg.budget_action = SO_BUDGET_REPORT;
+	arg.group = NULL;
+	arg.cpu_mask = 0;
+	return fork_thread(&arg);
+}
+
+tid_t so_fork_arg(so_arg_handler handler, void *user_arg,
+		unsigned int priority)
+{
+	so_thread_arg_t arg;
+
+	/* check if proper parameters were given */
+	if (handler == NULL || priority > SO_MAX_PRIORITY)
+		return INVALID_TID;
+
+	arg.handler = NULL;
+	arg.arg_handler = handler;
+	arg.future_handler = NULL;
+	arg.user_arg = user_arg;
+	arg.priority = priority;
+	arg.flags = 0;
+	arg.budget = 0;
+	arg.budget_action = SO_BUDGET_REPORT;
+	arg.group = NULL;
+	arg.cpu_mask = 0;
+	return fork_thread(&arg);
+}
+
+so_future_t so_fork_future(so_future_handler handler, void *user_arg,
+		unsigned int priority)
+{
+	so_thread_arg_t arg;
+
+	/* check if proper parameters were given */
+	if (handler == NULL || priority > SO_MAX_PRIORITY)
+		return INVALID_TID;
+
+	arg.handler = NULL;
+	arg.arg_handler = NULL;
+	arg.future_handler = handler;
+	arg.user_arg = user_arg;
+	arg.priority = priority;
+	arg.flags = 0;
+	arg.budget = 0;
+	arg.budget_action = SO_BUDGET_REPORT;
+	arg.group = NULL;
+	arg.cpu_mask = 0;
+	return fork_thread(&arg);
+}
+
+void so_task_attr_init(so_task_attr_t *attr)
+{
+	attr->priority = SO_MIN_PRIORITY;
+	attr->flags = 0;
+	attr->budget = 0;
+	attr->budget_action = SO_BUDGET_REPORT;
+	attr->group = NULL;
+	attr->cpu_mask = 0;
+}
+
+tid_t so_fork_attr(so_arg_handler handler, void *user_arg,
+		const so_task_attr_t *attr)
+{
+	so_thread_arg_t arg;
+
+	/* check if proper parameters were given */
+	if (handler == NULL || attr == NULL ||
+		attr->priority > SO_MAX_PRIORITY ||
+		attr->budget_action > SO_BUDGET_REPORT)
+		return INVALID_TID;
+
+	arg.handler = NULL;
+	arg.arg_handler = handler;
+	arg.future_handler = NULL;
+	arg.user_arg = user_arg;
+	arg.priority = attr->priority;
+	arg.flags = attr->flags;
+	arg.budget = attr->budget;
+	arg.budget_action = attr->budget_action;
+	arg.group = attr->group;
+	arg.cpu_mask = attr->cpu_mask;
+	return fork_thread(&arg);
+}
+
+so_task_group_t *so_task_group_create(so_task_group_t *parent,
+		unsigned int weight)
+{
+	so_scheduler_t *sched = get_scheduler();
+	priority_queue_t *ready;
+	task_group_t *group;
+
+	if (sched->initialized == FALSE)
+		return NULL;
+
+	LOCK(sched);
+	if (parent == NULL)
+		parent = sched->root_group;
+
+	ready = so_sched_queue_init();
+	group = task_group_init(parent, weight, ready);
+	if (group == NULL)
+		priority_queue_free(ready);
+	UNLOCK(sched);
+	return group;
+}
+
+int so_task_group_set_quota(so_task_group_t *group, unsigned long quota,
+		unsigned long period)
+{
+	so_scheduler_t *sched = get_scheduler();
+
+	/* check if proper parameters were given */
+	if (group == NULL || group->parent == NULL ||
+		(quota != 0 && (period == 0 || quota > period)))
+		return SO_FAILURE;
+
+	/* the new quota is applied from the current period on */
+	LOCK(sched);
+	group->quota = quota;
+	group->period = period;
+	group->used = 0;
+	if (quota != 0)
+		group->period_index = sched->clock / period;
+	UNLOCK(sched);
+	return SO_SUCCESS;
+}
+
+int so_task_group_set_gang(so_task_group_t *group, int gang)
+{
+	so_scheduler_t *sched = get_scheduler();
+
+	if (group == NULL || group->parent == NULL)
+		return SO_FAILURE;
+
+	LOCK(sched);
+	group->gang = gang ? TRUE : FALSE;
+	if (sched->gang == group && group->gang == FALSE)
+		sched->gang = NULL;
+	UNLOCK(sched);
+	return SO_SUCCESS;
+}
+
+int so_task_group_destroy(so_task_group_t *group)
+{
+	so_scheduler_t *sched = get_scheduler();
+	int status = SO_SUCCESS;
+
+	if (group == NULL || group->parent == NULL)
+		return SO_FAILURE;
+
+	LOCK(sched);
+	if (group->children != NULL || group->nr_tasks != 0)
+		status = SO_FAILURE;
+	else {
+		if (sched->gang == group)
+			sched->gang = NULL;
+		task_group_free(group);
+	}
+	UNLOCK(sched);
+	return status;
+}
+
+int so_sched_set_quantum(unsigned int priority, unsigned int q_time)
+{
+	so_scheduler_t *sched = get_scheduler();
+
+	if (sched->initialized == FALSE ||
+		priority > SO_MAX_PRIORITY ||
+		q_time == 0)
+		return SO_FAILURE;
+
+	LOCK(sched);
+	sched->q_time[priority] = q_time;
+	UNLOCK(sched);
+	return SO_SUCCESS;
+}
+
+int so_sched_set_adaptive(unsigned int min_quantum,
+		unsigned int max_quantum, unsigned int target)
+{
+	so_scheduler_t *sched = get_scheduler();
+
+	if (sched->initialized == FALSE ||
+		target >= 100 ||
+		(target != 0 && (min_quantum == 0 ||
+			min_quantum > max_quantum)))
+		return SO_FAILURE;
+
+	LOCK(sched);
+	sched->adapt_target = target;
+	sched->adapt_min = min_quantum;
+	sched->adapt_max = max_quantum;
+	sched->adapt_quantum = min_quantum;
+	sched->adapt_switches = 0;
+	sched->switch_ns = 0;
+	sched->window_start = so_time_ns();
+	sched->switch_start = sched->window_start;
+	UNLOCK(sched);
+	return SO_SUCCESS;
+}
+
+unsigned int so_sched_get_quantum(unsigned int priority)
+{
+	so_scheduler_t *sched = get_scheduler();
+	unsigned int q_time;
+
+	if (sched->initialized == FALSE || priority > SO_MAX_PRIORITY)
+		return 0;
+
+	LOCK(sched);
+	if (sched->adapt_target != 0)
+		q_time = sched->adapt_quantum;
+	else
+		q_time = sched->q_time[priority];
+	UNLOCK(sched);
+	return q_time;
+}
+
+int so_sched_set_carry_over(int enable)
+{
+	so_scheduler_t *sched = get_scheduler();
+
+	if (sched->initialized == FALSE)
+		return SO_FAILURE;
+
+	LOCK(sched);
+	sched->carry_over = enable ? TRUE : FALSE;
+	UNLOCK(sched);
+	return SO_SUCCESS;
+}
+
+int so_sched_set_wake_affine(int enable)
+{
+	so_scheduler_t *sched = get_scheduler();
+
+	if (sched->initialized == FALSE)
+		return SO_FAILURE;
+
+	LOCK(sched);
+	sched->wake_affine = enable ? TRUE : FALSE;
+	UNLOCK(sched);
+	return SO_SUCCESS;
+}
+
+int so_sched_set_cpu(int cpu)
+{
+	so_scheduler_t *sched = get_scheduler();
+
+	/* check if proper parameters were given */
+	if (sched->initialized == FALSE ||
+		(cpu != -1 && so_cpu_valid(cpu) == FALSE))
+		return SO_FAILURE;
+
+	LOCK(sched);
+	sched->cpu = cpu;
+	UNLOCK(sched);
+	return SO_SUCCESS;
+}
+
+/* lock two schedulers, always in the same order */
+static void lock_pair(so_scheduler_t *first, so_scheduler_t *second)
+{
+	if (first > second)
+		lock_pair(second, first);
+	else {
+		LOCK(first);
+		LOCK(second);
+	}
+}
+
+/** check if a ready thread can move to another scheduler. It must not be
+ * tied to the tasks of its scheduler by joins, task mutexes, read-write
+ * locks or semaphore permits, its cpu mask has to allow the other
+ * scheduler and its tid has to be free there.
+ */
+static SO_BOOL can_migrate(so_thread_t *so_thread, so_scheduler_t *to)
+{
+	if (so_thread->status != READY ||
+		so_thread->queue != so_thread->group->ready)
+		return FALSE;
+
+	if (so_thread->owned_mutexes != NULL ||
+		so_thread->num_read_locks != 0 ||
+		so_thread->written_locks != NULL ||
+		so_thread->wait_cleanup != NULL ||
+		(so_thread->joiners != NULL &&
+		vector_size(so_thread->joiners) != 0))
+		return FALSE;
+
+	/* a task limited to some cpus goes only to schedulers pinned on them */
+	if (so_thread->arg.cpu_mask != 0 && (to->cpu < 0 ||
+		to->cpu >= (int)(sizeof(unsigned long) * 8) ||
+		!(so_thread->arg.cpu_mask & (1UL << to->cpu))))
+		return FALSE;
+
+	return task_table_find(to->tasks, TID_KEY(so_thread->tid)) ==
+			INVALID_HANDLE ? TRUE : FALSE;
+}
+
+/** move a ready thread to the root group of another scheduler, at the end
+ * of its priority. An idle scheduler runs it right away.
+ * @return FALSE if its thread cannot be pinned to the cpu of the other
+ * scheduler, in which case it is not moved
+ */
+static SO_BOOL migrate_thread(so_thread_t *so_thread, so_scheduler_t *to)
+{
+	so_scheduler_t *from = so_thread->sched;
+	unsigned long idle;
+
+	if (to->cpu >= 0 && so_thread->has_context == TRUE &&
+		so_set_thread_cpu(so_thread->thread, to->cpu) == FALSE)
+		return FALSE;
+
+	remove_ready(so_thread);
+	so_thread->group->nr_tasks--;
+	task_table_remove(from->tasks, so_thread->handle);
+	from->num_active_threads--;
+	if (from->num_active_threads == 0)
+		so_condition_notify(&from->finish_cond);
+
+	so_thread->sched = to;
+	so_thread->group = to->root_group;
+	so_thread->group->nr_tasks++;
+	so_thread->remaining_time = quantum(so_thread);
+	so_thread->thread_timestamp = ++to->timestamp;
+
+	/** the clocks of the schedulers are not related, so the time since
+	 * the thread last ran is kept, counted back from the new clock
+	 */
+	if (so_thread->last_run != 0) {
+		idle = from->clock - so_thread->last_run;
+		so_thread->last_run = to->clock > idle ? to->clock - idle : 0;
+	}
+	so_thread->handle = task_table_insert(to->tasks,
+					TID_KEY(so_thread->tid), so_thread);
+	DIE(so_thread->handle == INVALID_HANDLE, "task table insert failed");
+	to->num_active_threads++;
+
+	/* a scheduler with no running thread has no ready thread either */
+	if (to->running_thread == NULL)
+		dispatch(so_thread, FALSE);
+	else
+		add_ready(so_thread);
+	return TRUE;
+}
+
+/* collect the ready threads of a group and of its subgroups */
+static void collect_ready(task_group_t *group, vector_t *threads)
+{
+	task_group_t *child;
+	size_t i;
+
+	for (i = 0; i < priority_queue_size(group->ready); i++)
+		vector_push_back(threads,
+				priority_queue_get(group->ready, i));
+
+	for (child = group->children; child; child = child->next_sibling)
+		collect_ready(child, threads);
+}
+
+int so_sched_migrate(tid_t tid, so_sched_t *to)
+{
+	so_scheduler_t *sched = get_scheduler();
+	so_thread_t *so_thread;
+	int status = SO_FAILURE;
+
+	if (to == NULL || to == sched || to->initialized == FALSE)
+		return SO_FAILURE;
+
+	lock_pair(sched, to);
+	so_thread = find_thread(tid);
+	if (so_thread != NULL && can_migrate(so_thread, to) == TRUE &&
+		migrate_thread(so_thread, to) == TRUE)
+		status = SO_SUCCESS;
+	UNLOCK(to);
+
+	if (sched->running_thread != NULL)
+		spend_time(sched->running_thread);
+	UNLOCK(sched);
+
+	reschedule();
+	return status;
+}
+
+/** move all the ready threads that can be moved to another scheduler, in
+ * the order they would run, so the ones with the same priority keep their
+ * order there. Both schedulers have to be locked.
+ */
+static int drain_scheduler(so_scheduler_t *from, so_scheduler_t *to)
+{
+	so_thread_t **threads;
+	vector_t *ready;
+	size_t i;
+	int moved = 0;
+
+	ready = vector_init(sizeof(so_thread_t *));
+	collect_ready(from->root_group, ready);
+	threads = (so_thread_t **) vector_get_front(ready);
+	if (vector_size(ready) > 0)
+		qsort(threads, vector_size(ready), sizeof(so_thread_t *),
+				compare_so_threads);
+
+	for (i = 0; i < vector_size(ready); i++) {
+		if (can_migrate(threads[i], to) == FALSE ||
+			migrate_thread(threads[i], to) == FALSE)
+			continue;
+		moved++;
+	}
+	free_vector(ready);
+	return moved;
+}
+
+int so_sched_drain(so_sched_t *to)
+{
+	so_scheduler_t *sched = get_scheduler();
+	int moved;
+
+	if (to == NULL || to == sched || to->initialized == FALSE)
+		return SO_FAILURE;
+
+	lock_pair(sched, to);
+	moved = drain_scheduler(sched, to);
+	UNLOCK(to);
+
+	if (sched->running_thread != NULL)
+		spend_time(sched->running_thread);
+	UNLOCK(sched);
 
-	so_thread->thread_timestamp = ++timestamp;
-	so_scheduler.num_active_threads++;
-	priority_queue_push(pq, &so_thread);
-	UNLOCK(so_scheduler);
 	reschedule();
-	return (tid_t)*thread;
+	return moved;
+}
+
+int so_sched_ready_tasks(so_sched_t *sched)
+{
+	int ready;
+
+	if (sched == NULL)
+		sched = get_scheduler();
+	if (sched->initialized == FALSE)
+		return SO_FAILURE;
+
+	LOCK(sched);
+	ready = (int)sched->root_group->nr_ready;
+	UNLOCK(sched);
+	return ready;
+}
+
+/* the load a ready thread puts on its scheduler */
+static unsigned long thread_load(so_thread_t *so_thread)
+{
+	return so_thread->arg.priority + 1;
+}
+
+/* compute the load of a scheduler, its scheduler has to be locked */
+static unsigned long scheduler_load(so_scheduler_t *sched)
+{
+	unsigned long load = 0;
+	vector_t *ready;
+	size_t i;
+
+	ready = vector_init(sizeof(so_thread_t *));
+	collect_ready(sched->root_group, ready);
+	for (i = 0; i < vector_size(ready); i++)
+		load += thread_load(*(so_thread_t **) vector_get(ready, i));
+	free_vector(ready);
+	return load;
+}
+
+/* sort threads by the time they last ran, the ones run long ago first */
+static int compare_last_run(const void *first, const void *second)
+{
+	so_thread_t *first_th = *(so_thread_t **)first;
+	so_thread_t *second_th = *(so_thread_t **)second;
+
+	if (first_th->last_run != second_th->last_run)
+		return first_th->last_run < second_th->last_run ? -1 : 1;
+	return compare_so_threads(first, second);
+}
+
+/** move ready threads from a scheduler to a less loaded one, the ones
+ * whose cache is the coldest first. A thread is moved only while the
+ * receiving scheduler stays less loaded, so the threads are not moved back
+ * at the next call.
+ */
+static int balance_pair(so_scheduler_t *busiest, so_scheduler_t *idlest)
+{
+	unsigned long busiest_load, idlest_load, load;
+	so_thread_t **threads;
+	vector_t *ready;
+	size_t i;
+	int moved = 0;
+
+	lock_pair(busiest, idlest);
+	busiest_load = scheduler_load(busiest);
+	idlest_load = scheduler_load(idlest);
+
+	ready = vector_init(sizeof(so_thread_t *));
+	collect_ready(busiest->root_group, ready);
+	threads = (so_thread_t **) vector_get_front(ready);
+	if (vector_size(ready) > 0)
+		qsort(threads, vector_size(ready), sizeof(so_thread_t *),
+				compare_last_run);
+
+	for (i = 0; i < vector_size(ready) &&
+		moved < SO_BALANCE_MAX_MOVES; i++) {
+		load = thread_load(threads[i]);
+		if (busiest_load < 2 * load ||
+			idlest_load + load >= busiest_load - load)
+			continue;
+		if (can_migrate(threads[i], idlest) == FALSE ||
+			migrate_thread(threads[i], idlest) == FALSE)
+			continue;
+
+		busiest_load -= load;
+		idlest_load += load;
+		moved++;
+	}
+	free_vector(ready);
+
+	UNLOCK(idlest);
+	UNLOCK(busiest);
+	return moved;
+}
+
+int so_sched_balance(so_sched_t **scheds, unsigned int count)
+{
+	so_scheduler_t *busiest = NULL, *idlest = NULL;
+	unsigned long load, busiest_load = 0, idlest_load = 0;
+	unsigned int i;
+
+	if (scheds == NULL || count == 0)
+		return SO_FAILURE;
+
+	/* find the most and the least loaded schedulers */
+	for (i = 0; i < count; i++) {
+		if (scheds[i] == NULL || scheds[i]->initialized == FALSE)
+			return SO_FAILURE;
+
+		LOCK(scheds[i]);
+		load = scheduler_load(scheds[i]);
+		UNLOCK(scheds[i]);
+
+		if (busiest == NULL || load > busiest_load) {
+			busiest = scheds[i];
+			busiest_load = load;
+		}
+		if (idlest == NULL || load < idlest_load) {
+			idlest = scheds[i];
+			idlest_load = load;
+		}
+	}
+
+	if (busiest == idlest)
+		return 0;
+	return balance_pair(busiest, idlest);
+}
+
+/* create a scheduler with the quanta and the devices of another one */
+static so_scheduler_t *clone_scheduler(so_scheduler_t *like)
+{
+	so_scheduler_t *sched;
+
+	sched = so_sched_create(like->q_time[0], like->num_io_devices);
+	if (sched == NULL)
+		return NULL;
+
+	LOCK(like);
+	memcpy(sched->q_time, like->q_time, sizeof(sched->q_time));
+	UNLOCK(like);
+	return sched;
+}
+
+/** drain the last scheduler of a set into the least loaded of the others
+ * and destroy it if nothing is left in it
+ * @return TRUE if it was destroyed
+ */
+static SO_BOOL shrink_set(so_sched_t **scheds, unsigned int count)
+{
+	so_scheduler_t *last = scheds[count - 1], *idlest = NULL;
+	unsigned long load, idlest_load = 0;
+	unsigned int i;
+	SO_BOOL empty;
+
+	/** the default scheduler and the one of the caller are not
+	 * destroyed here
+	 */
+	if (last == &default_scheduler || last == get_scheduler())
+		return FALSE;
+
+	for (i = 0; i < count - 1; i++) {
+		LOCK(scheds[i]);
+		load = scheduler_load(scheds[i]);
+		UNLOCK(scheds[i]);
+
+		if (idlest == NULL || load < idlest_load) {
+			idlest = scheds[i];
+			idlest_load = load;
+		}
+	}
+
+	lock_pair(last, idlest);
+	drain_scheduler(last, idlest);
+	empty = last->num_active_threads == 0 ? TRUE : FALSE;
+	UNLOCK(idlest);
+	UNLOCK(last);
+
+	if (empty == TRUE)
+		so_sched_destroy(last);
+	return empty;
+}
+
+int so_sched_autoscale(so_sched_t **scheds, unsigned int *count,
+		unsigned int max)
+{
+	so_scheduler_t *sched;
+	unsigned long ready = 0;
+	unsigned int i;
+
+	if (scheds == NULL || count == NULL || *count == 0 || *count > max)
+		return SO_FAILURE;
+
+	for (i = 0; i < *count; i++) {
+		if (scheds[i] == NULL || scheds[i]->initialized == FALSE)
+			return SO_FAILURE;
+
+		LOCK(scheds[i]);
+		ready += scheds[i]->root_group->nr_ready;
+		UNLOCK(scheds[i]);
+	}
+
+	/** add a scheduler while there are too many ready tasks for each one
+	 * and let the balancer give it some of them
+	 */
+	if (ready > SO_SCALE_UP_READY * *count && *count < max) {
+		sched = clone_scheduler(scheds[0]);
+		if (sched == NULL)
+			return SO_FAILURE;
+
+		scheds[(*count)++] = sched;
+		so_sched_balance(scheds, *count);
+		return SO_SUCCESS;
+	}
+
+	/* remove one while the others would still have few ready tasks */
+	if (*count > 1 && ready < SO_SCALE_DOWN_READY * (*count - 1) &&
+		shrink_set(scheds, *count) == TRUE)
+		(*count)--;
+	return SO_SUCCESS;
 }
@@ -0,0 +1,92 @@
+/* Copyright Radu Nichita radunichita99@gmail.com */
+#include "so_sched_internal.h"
+#include "utils.h"
+
+/** struct for keeping a parallel loop while it runs
+ * next = first index not taken by a worker yet
+ * end = index after the last one
+ * grain = maximum number of indexes in a chunk
+ * handler = function to be executed for each chunk with arg
+ * arg = argument given to the handler
+ */
+typedef struct {
+	unsigned long next;
+	unsigned long end;
+	unsigned long grain;
+	so_range_handler handler;
+	void *arg;
+} so_parallel_for_t;
+
+/** take the next chunk of a loop. Taking a chunk is a scheduling point, so
+ * the workers share the processor like any other tasks.
+ * @return FALSE if all the chunks were taken
+ */
+static SO_BOOL take_chunk(so_parallel_for_t *loop, unsigned long *begin,
+	unsigned long *end)
+{
+	SO_BOOL taken = FALSE;
+
+	so_sched_enter();
+
+	if (loop->next < loop->end) {
+		*begin = loop->next;
+		if (loop->end - loop->next > loop->grain)
+			*end = loop->next + loop->grain;
+		else
+			*end = loop->end;
+		loop->next = *end;
+		taken = TRUE;
+	}
+
+	so_sched_leave();
+	return taken;
+}
+
+/* run chunks until none is left */
+static void run_worker(void *arg)
+{
+	so_parallel_for_t *loop = arg;
+	unsigned long begin, end;
+
+	while (take_chunk(loop, &begin, &end) == TRUE)
+		loop->handler(begin, end, loop->arg);
+}
+
+/* run a handler over the chunks of a range */
+int so_parallel_for(unsigned long begin, unsigned long end,
+	unsigned long grain, so_range_handler handler, void *arg)
+{
+	tid_t tids[SO_PARALLEL_WORKERS];
+	so_parallel_for_t loop;
+	so_task_attr_t attr;
+	unsigned long num_chunks;
+	unsigned int num_workers, i;
+
+	if (handler == NULL || grain == 0 || begin > end)
+		return SO_FAILURE;
+
+	loop.next = begin;
+	loop.end = end;
+	loop.grain = grain;
+	loop.handler = handler;
+	loop.arg = arg;
+
+	num_chunks = (end - begin) / grain + ((end - begin) % grain != 0);
+	num_workers = num_chunks < SO_PARALLEL_WORKERS ?
+		(unsigned int) num_chunks : SO_PARALLEL_WORKERS;
+
+	/** the workers are inline tasks with the priority of the caller, so
+	 * they get a thread only when they are first dispatched
+	 */
+	so_task_attr_init(&attr);
+	attr.priority = so_sched_enter()->base_priority;
+	attr.flags = SO_TASK_INLINE;
+	so_sched_leave();
+
+	for (i = 0; i < num_workers; i++) {
+		tids[i] = so_fork_attr(run_worker, &loop, &attr);
+		DIE(tids[i] == INVALID_TID, "worker fork failed");
+	}
+
+	return so_wait_all(tids, num_workers);
+}
@@ -0,0 +1,63 @@
+/* Copyright Radu Nichita radunichita99@gmail.com */
+#include "so_sched_internal.h"
+#include "utils.h"
+
+/* initialize a task barrier */
+int so_task_barrier_init(so_task_barrier_t *barrier, unsigned int count)
+{
+	if (barrier == NULL || count == 0)
+		return SO_FAILURE;
+
+	barrier->count = count;
+	barrier->arrived = 0;
+	barrier->sched = NULL;
+	barrier->waiters = so_sched_queue_init();
+	return SO_SUCCESS;
+}
+
+/* a task cancelled while waiting at the barrier no longer counts */
+static void leave_barrier(void *object)
+{
+	so_task_barrier_t *barrier = object;
+
+	barrier->arrived--;
+}
+
+/* wait for all the tasks to reach the barrier */
+int so_task_barrier_wait(so_task_barrier_t *barrier)
+{
+	int status = 0;
+
+	if (barrier == NULL || barrier->waiters == NULL ||
+		so_sched_bind(&barrier->sched) < 0)
+		return SO_FAILURE;
+
+	so_sched_enter();
+
+	/** the last task releases the others in priority order and keeps
+	 * running, so the barrier can be reused right away
+	 */
+	if (++barrier->arrived == barrier->count) {
+		while (!priority_queue_empty(barrier->waiters))
+			so_sched_wake(so_sched_dequeue(barrier->waiters));
+		barrier->arrived = 0;
+		status = SO_BARRIER_SERIAL;
+	} else {
+		so_sched_park_cleanup(barrier->waiters, leave_barrier,
+				barrier);
+	}
+
+	so_sched_leave();
+	return status;
+}
+
+/* destroy a task barrier */
+void so_task_barrier_destroy(so_task_barrier_t *barrier)
+{
+	if (barrier == NULL || barrier->waiters == NULL)
+		return;
+
+	DIE(!priority_queue_empty(barrier->waiters), "task barrier in use");
+	priority_queue_free(barrier->waiters);
+	barrier->waiters = NULL;
+}
@@ -0,0 +1,219 @@
+/* Copyright Radu Nichita radunichita99@gmail.com */
+#include <stdlib.h>
+#include <string.h>
+
+#include "so_sched_internal.h"
+#include "utils.h"
+
+/* initialize a bounded channel */
+int so_task_chan_init(so_task_chan_t *chan, size_t elem_size,
+	unsigned int capacity)
+{
+	if (chan == NULL || elem_size == 0 || capacity == 0)
+		return SO_FAILURE;
+
+	chan->buffer = malloc(elem_size * capacity);
+	DIE(chan->buffer == NULL, "malloc failed");
+
+	chan->elem_size = elem_size;
+	chan->capacity = capacity;
+	chan->head = 0;
+	chan->count = 0;
+	chan->sched = NULL;
+	chan->senders = so_sched_queue_init();
+	chan->receivers = so_sched_queue_init();
+	return SO_SUCCESS;
+}
+
+static unsigned int min_elems(unsigned int first, unsigned int second)
+{
+	return first < second ? first : second;
+}
+
+/** copy elements in the ring buffer after the last one.
+ * There must be room for all of them.
+ */
+static void push_elems(so_task_chan_t *chan, const char *elems,
+	unsigned int count)
+{
+	unsigned int tail = (chan->head + chan->count) % chan->capacity;
+	unsigned int first = min_elems(count, chan->capacity - tail);
+
+	memcpy(chan->buffer + tail * chan->elem_size, elems,
+		first * chan->elem_size);
+	memcpy(chan->buffer, elems + first * chan->elem_size,
+		(count - first) * chan->elem_size);
+	chan->count += count;
+}
+
+/* copy the oldest elements out of the ring buffer */
+static void pop_elems(so_task_chan_t *chan, char *elems, unsigned int count)
+{
+	unsigned int first = min_elems(count, chan->capacity - chan->head);
+
+	memcpy(elems, chan->buffer + chan->head * chan->elem_size,
+		first * chan->elem_size);
+	memcpy(elems + first * chan->elem_size, chan->buffer,
+		(count - first) * chan->elem_size);
+	chan->head = (chan->head + count) % chan->capacity;
+	chan->count -= count;
+}
+
+/** move the elements of the waiting senders in the freed space, waking
+ * one sender for each of them
+ */
+static void refill(so_task_chan_t *chan)
+{
+	so_thread_t *sender;
+
+	while (chan->count < chan->capacity &&
+		!priority_queue_empty(chan->senders)) {
+		sender = so_sched_dequeue(chan->senders);
+		push_elems(chan, sender->wait_data, 1);
+		so_sched_wake(sender);
+	}
+}
+
+/** send elements until the channel is full, giving them directly to the
+ * waiting receivers first. A receiver waits only while the buffer is
+ * empty, so this keeps the order of the elements.
+ * @return number of elements sent
+ */
+static unsigned int send_elems(so_task_chan_t *chan, const char *elems,
+	unsigned int count)
+{
+	so_thread_t *receiver;
+	unsigned int sent = 0;
+	unsigned int room;
+
+	while (sent < count && !priority_queue_empty(chan->receivers)) {
+		receiver = so_sched_dequeue(chan->receivers);
+		memcpy(receiver->wait_data, elems + sent * chan->elem_size,
+			chan->elem_size);
+		so_sched_wake(receiver);
+		sent++;
+	}
+
+	room = min_elems(count - sent, chan->capacity - chan->count);
+	push_elems(chan, elems + sent * chan->elem_size, room);
+	return sent + room;
+}
+
+/** send the elements in order, parking on each element that does not fit;
+ * a parked element is moved in the buffer by the receiver that frees
+ * room for it
+ */
+static void send_all(so_task_chan_t *chan, const char *elems,
+	unsigned int count)
+{
+	so_thread_t *running_thread;
+	unsigned int sent;
+
+	running_thread = so_sched_enter();
+	for (;;) {
+		sent = send_elems(chan, elems, count);
+		if (sent == count)
+			break;
+
+		running_thread->wait_data = (void *) (elems +
+			sent * chan->elem_size);
+		so_sched_park(chan->senders);
+		so_sched_leave();
+
+		elems += (sent + 1) * chan->elem_size;
+		count -= sent + 1;
+		if (count == 0)
+			return;
+		running_thread = so_sched_enter();
+	}
+	so_sched_leave();
+}
+
+/* send an element */
+int so_task_chan_send(so_task_chan_t *chan, const void *elem)
+{
+	if (chan == NULL || chan->senders == NULL || elem == NULL ||
+		so_sched_bind(&chan->sched) < 0)
+		return SO_FAILURE;
+
+	send_all(chan, elem, 1);
+	return SO_SUCCESS;
+}
+
+/* send a group of elements */
+int so_task_chan_send_many(so_task_chan_t *chan, const void *elems,
+	unsigned int count)
+{
+	if (chan == NULL || chan->senders == NULL || elems == NULL ||
+		so_sched_bind(&chan->sched) < 0)
+		return SO_FAILURE;
+
+	if (count != 0)
+		send_all(chan, elems, count);
+	return SO_SUCCESS;
+}
+
+/** receive up to count elements, waiting for a sender to hand one over
+ * if the buffer is empty
+ * @return number of elements received
+ */
+static unsigned int recv_elems(so_task_chan_t *chan, char *elems,
+	unsigned int count)
+{
+	so_thread_t *running_thread;
+	unsigned int received;
+
+	running_thread = so_sched_enter();
+
+	if (chan->count == 0) {
+		running_thread->wait_data = elems;
+		so_sched_park(chan->receivers);
+		received = 1;
+	} else {
+		received = min_elems(count, chan->count);
+		pop_elems(chan, elems, received);
+		refill(chan);
+	}
+
+	so_sched_leave();
+	return received;
+}
+
+/* receive an element */
+int so_task_chan_recv(so_task_chan_t *chan, void *elem)
+{
+	if (chan == NULL || chan->receivers == NULL || elem == NULL ||
+		so_sched_bind(&chan->sched) < 0)
+		return SO_FAILURE;
+
+	recv_elems(chan, elem, 1);
+	return SO_SUCCESS;
+}
+
+/* receive up to count elements */
+int so_task_chan_recv_many(so_task_chan_t *chan, void *elems,
+	unsigned int count)
+{
+	if (chan == NULL || chan->receivers == NULL || elems == NULL ||
+		count == 0 || so_sched_bind(&chan->sched) < 0)
+		return SO_FAILURE;
+
+	return recv_elems(chan, elems, count);
+}
+
+/* destroy a bounded channel */
+void so_task_chan_destroy(so_task_chan_t *chan)
+{
+	if (chan == NULL || chan->senders == NULL)
+		return;
+
+	DIE(!priority_queue_empty(chan->senders) ||
+		!priority_queue_empty(chan->receivers),
+		"task channel in use");
+	priority_queue_free(chan->senders);
+	priority_queue_free(chan->receivers);
+	free(chan->buffer);
+	chan->senders = NULL;
+	chan->receivers = NULL;
+	chan->buffer = NULL;
+}
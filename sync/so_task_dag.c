@@ -0,0 +1,262 @@
+/* Copyright Radu Nichita radunichita99@gmail.com */
+#include <stdlib.h>
+
+#include "so_scheduler.h"
+#include "utils.h"
+
+struct so_task_dag;
+
+/** struct for keeping the argument of the wrapper of a task
+ * dag = graph of the task
+ * index = index of the task in the graph
+ */
+typedef struct {
+	struct so_task_dag *dag;
+	unsigned int index;
+} so_task_dag_arg_t;
+
+/** struct for keeping a graph while it runs
+ * nodes = tasks given by the user
+ * succ_start = successors of the ith task are succ[succ_start[i]] up to
+ * succ[succ_start[i + 1]]
+ * succ = successors of all the tasks
+ * pending = number of tasks each task still waits for
+ * priority = priority each task is forked with
+ * args = arguments of the task wrappers
+ * tids = tids of the forked tasks, in the order they were forked
+ * num_forked = number of entries in tids
+ */
+typedef struct so_task_dag {
+	const so_task_dag_node_t *nodes;
+	unsigned int *succ_start;
+	unsigned int *succ;
+	unsigned int *pending;
+	unsigned int *priority;
+	so_task_dag_arg_t *args;
+	tid_t *tids;
+	unsigned int num_forked;
+} so_task_dag_t;
+
+static void run_dag_node(void *arg);
+
+/** fork a task whose dependencies have terminated. The task is inline, so
+ * a chain of tasks reuses the thread of the task releasing it.
+ */
+static void fork_dag_node(so_task_dag_t *dag, unsigned int index)
+{
+	so_task_attr_t attr;
+	tid_t tid;
+
+	so_task_attr_init(&attr);
+	attr.priority = dag->priority[index];
+	attr.flags = SO_TASK_INLINE;
+	tid = so_fork_attr(run_dag_node, &dag->args[index], &attr);
+	DIE(tid == INVALID_TID, "dag fork failed");
+	dag->tids[dag->num_forked++] = tid;
+}
+
+/** run a task, then release the tasks depending only on it. A cancelled
+ * task does not get past its handler, so its dependants are never forked.
+ */
+static void run_dag_node(void *arg)
+{
+	so_task_dag_arg_t *dag_arg = arg;
+	so_task_dag_t *dag = dag_arg->dag;
+	unsigned int index = dag_arg->index;
+	unsigned int i;
+
+	dag->nodes[index].handler(dag->nodes[index].arg);
+
+	/** only one task runs at a time and the counters are changed only
+	 * between scheduler calls, so they need no lock
+	 */
+	for (i = dag->succ_start[index]; i < dag->succ_start[index + 1]; i++)
+		if (--dag->pending[dag->succ[i]] == 0)
+			fork_dag_node(dag, dag->succ[i]);
+}
+
+/** build the successor lists and the number of dependencies of each task
+ * @return SO_FAILURE if an edge has an invalid task
+ */
+static int build_edges(so_task_dag_t *dag, unsigned int num_nodes,
+	const so_task_dag_edge_t *edges, unsigned int num_edges)
+{
+	unsigned int i;
+
+	for (i = 0; i < num_edges; i++) {
+		if (edges[i].from >= num_nodes || edges[i].to >= num_nodes)
+			return SO_FAILURE;
+		dag->succ_start[edges[i].from + 1]++;
+		dag->pending[edges[i].to]++;
+	}
+
+	for (i = 0; i < num_nodes; i++)
+		dag->succ_start[i + 1] += dag->succ_start[i];
+
+	/* fill each list from its end, using priority as a cursor */
+	for (i = 0; i < num_nodes; i++)
+		dag->priority[i] = dag->succ_start[i + 1];
+	for (i = num_edges; i > 0; i--)
+		dag->succ[--dag->priority[edges[i - 1].from]] = edges[i - 1].to;
+
+	return SO_SUCCESS;
+}
+
+/** sort the tasks topologically
+ * order = array of num_nodes elements for the sorted tasks
+ * @return SO_FAILURE if the graph has a cycle
+ */
+static int sort_dag(so_task_dag_t *dag, unsigned int num_nodes,
+	unsigned int *order)
+{
+	unsigned int *in_degree = dag->priority;
+	unsigned int head = 0, tail = 0;
+	unsigned int i, node;
+
+	for (i = 0; i < num_nodes; i++) {
+		in_degree[i] = dag->pending[i];
+		if (in_degree[i] == 0)
+			order[tail++] = i;
+	}
+
+	while (head < tail) {
+		node = order[head++];
+		for (i = dag->succ_start[node]; i < dag->succ_start[node + 1];
+			i++)
+			if (--in_degree[dag->succ[i]] == 0)
+				order[tail++] = dag->succ[i];
+	}
+
+	return tail == num_nodes ? SO_SUCCESS : SO_FAILURE;
+}
+
+/** give each task a priority proportional to the longest path from it to
+ * the end of the graph, so the tasks on the critical path run first
+ */
+static void set_critical_path(so_task_dag_t *dag, unsigned int num_nodes,
+	const unsigned int *order)
+{
+	unsigned int *level = dag->priority;
+	unsigned int max_level = 1;
+	unsigned int i, j, node;
+
+	for (i = num_nodes; i > 0; i--) {
+		node = order[i - 1];
+		level[node] = 1;
+		for (j = dag->succ_start[node]; j < dag->succ_start[node + 1];
+			j++)
+			if (level[dag->succ[j]] + 1 > level[node])
+				level[node] = level[dag->succ[j]] + 1;
+		if (level[node] > max_level)
+			max_level = level[node];
+	}
+
+	for (i = 0; i < num_nodes; i++)
+		level[i] = SO_MIN_PRIORITY + (unsigned long) (level[i] - 1) *
+			(SO_MAX_PRIORITY - SO_MIN_PRIORITY) /
+			(max_level > 1 ? max_level - 1 : 1);
+}
+
+/* free a graph */
+static void free_dag(so_task_dag_t *dag)
+{
+	free(dag->succ_start);
+	free(dag->succ);
+	free(dag->pending);
+	free(dag->priority);
+	free(dag->args);
+	free(dag->tids);
+}
+
+/** wait for the forked tasks until there are no more. A task is forked
+ * only by the caller or by a task before it terminates, so the tasks
+ * forked while waiting are waited for in the next round.
+ * @return SO_FAILURE if any task was cancelled
+ */
+static int join_dag(so_task_dag_t *dag)
+{
+	unsigned int joined = 0, forked;
+	int status = SO_SUCCESS;
+
+	while (joined < dag->num_forked) {
+		forked = dag->num_forked;
+		if (so_wait_all(&dag->tids[joined], forked - joined) != 0)
+			status = SO_FAILURE;
+		joined = forked;
+	}
+
+	return status;
+}
+
+/* run a graph of tasks */
+int so_task_dag_run(const so_task_dag_node_t *nodes, unsigned int num_nodes,
+	const so_task_dag_edge_t *edges, unsigned int num_edges,
+	unsigned int flags)
+{
+	so_task_dag_t dag;
+	unsigned int *order;
+	unsigned int num_roots;
+	unsigned int i;
+	int status;
+
+	if ((nodes == NULL && num_nodes != 0) ||
+		(edges == NULL && num_edges != 0))
+		return SO_FAILURE;
+
+	for (i = 0; i < num_nodes; i++)
+		if (nodes[i].handler == NULL ||
+			nodes[i].priority > SO_MAX_PRIORITY)
+			return SO_FAILURE;
+
+	if (num_nodes == 0)
+		return SO_SUCCESS;
+
+	dag.nodes = nodes;
+	dag.succ_start = calloc(num_nodes + 1, sizeof(unsigned int));
+	dag.succ = malloc((num_edges + 1) * sizeof(unsigned int));
+	dag.pending = calloc(num_nodes, sizeof(unsigned int));
+	dag.priority = malloc(num_nodes * sizeof(unsigned int));
+	dag.args = malloc(num_nodes * sizeof(so_task_dag_arg_t));
+	dag.tids = malloc(num_nodes * sizeof(tid_t));
+	order = malloc(num_nodes * sizeof(unsigned int));
+	DIE(dag.succ_start == NULL || dag.succ == NULL || dag.pending == NULL ||
+		dag.priority == NULL || dag.args == NULL || dag.tids == NULL ||
+		order == NULL, "malloc failed");
+
+	/* check the whole graph before forking any task */
+	status = build_edges(&dag, num_nodes, edges, num_edges);
+	if (status == SO_SUCCESS)
+		status = sort_dag(&dag, num_nodes, order);
+	if (status == SO_FAILURE) {
+		free(order);
+		free_dag(&dag);
+		return SO_FAILURE;
+	}
+
+	if (flags & SO_TASK_DAG_CRITICAL_PATH)
+		set_critical_path(&dag, num_nodes, order);
+	else
+		for (i = 0; i < num_nodes; i++)
+			dag.priority[i] = nodes[i].priority;
+
+	for (i = 0; i < num_nodes; i++) {
+		dag.args[i].dag = &dag;
+		dag.args[i].index = i;
+	}
+	dag.num_forked = 0;
+
+	/** the tasks with no dependencies come first in the topological
+	 * order. They are counted before forking any of them, as a forked
+	 * task may run right away and release other tasks.
+	 */
+	for (num_roots = 0; num_roots < num_nodes; num_roots++)
+		if (dag.pending[order[num_roots]] != 0)
+			break;
+	for (i = 0; i < num_roots; i++)
+		fork_dag_node(&dag, order[i]);
+	free(order);
+
+	status = join_dag(&dag);
+	free_dag(&dag);
+	return status;
+}
@@ -0,0 +1,132 @@
+/* Copyright Radu Nichita radunichita99@gmail.com */
+#include "so_sched_internal.h"
+#include "utils.h"
+
+/* initialize a task mutex */
+int so_task_mutex_init(so_task_mutex_t *mutex)
+{
+	if (mutex == NULL)
+		return SO_FAILURE;
+
+	mutex->owner = NULL;
+	mutex->next_owned = NULL;
+	mutex->sched = NULL;
+	mutex->waiters = so_sched_queue_init();
+	return SO_SUCCESS;
+}
+
+/* add the mutex in the list of mutexes held by a thread */
+static void take_mutex(so_task_mutex_t *mutex, so_thread_t *owner)
+{
+	mutex->owner = owner;
+	mutex->next_owned = owner->owned_mutexes;
+	owner->owned_mutexes = mutex;
+}
+
+/* remove the mutex from the list of mutexes held by its owner */
+static void drop_mutex(so_task_mutex_t *mutex)
+{
+	so_task_mutex_t **link;
+
+	link = &mutex->owner->owned_mutexes;
+	while (*link != mutex)
+		link = &(*link)->next_owned;
+	*link = mutex->next_owned;
+
+	mutex->owner = NULL;
+	mutex->next_owned = NULL;
+}
+
+/* give a free mutex to the waiter with the highest priority, if any */
+static void hand_over(so_task_mutex_t *mutex)
+{
+	so_thread_t *next_owner;
+
+	if (priority_queue_empty(mutex->waiters))
+		return;
+
+	next_owner = so_sched_dequeue(mutex->waiters);
+	next_owner->blocked_on = NULL;
+	take_mutex(mutex, next_owner);
+	so_sched_wake(next_owner);
+	so_sched_update_priority(next_owner);
+}
+
+/* lock a task mutex */
+int so_task_mutex_lock(so_task_mutex_t *mutex)
+{
+	so_thread_t *running_thread;
+	int status = SO_SUCCESS;
+
+	if (mutex == NULL || mutex->waiters == NULL ||
+		so_sched_bind(&mutex->sched) < 0)
+		return SO_FAILURE;
+
+	running_thread = so_sched_enter();
+
+	if (mutex->owner == NULL) {
+		take_mutex(mutex, running_thread);
+	} else if (mutex->owner == running_thread) {
+		status = SO_FAILURE;
+	} else {
+		/** wait for the mutex and lend the priority to the owner,
+		 * the mutex is handed over by unlock, so there is nothing
+		 * to check after waking up
+		 */
+		running_thread->blocked_on = mutex;
+		so_sched_park(mutex->waiters);
+		so_sched_update_priority(mutex->owner);
+	}
+
+	so_sched_leave();
+	return status;
+}
+
+/* unlock a task mutex and hand it to the best waiter */
+int so_task_mutex_unlock(so_task_mutex_t *mutex)
+{
+	so_thread_t *running_thread;
+
+	if (mutex == NULL || mutex->waiters == NULL ||
+		so_sched_bind(&mutex->sched) < 0)
+		return SO_FAILURE;
+
+	running_thread = so_sched_enter();
+
+	if (mutex->owner != running_thread) {
+		so_sched_leave();
+		return SO_FAILURE;
+	}
+
+	drop_mutex(mutex);
+	hand_over(mutex);
+
+	/* give up the priority inherited through this mutex */
+	so_sched_update_priority(running_thread);
+
+	so_sched_leave();
+	return SO_SUCCESS;
+}
+
+/* hand the mutexes held by a terminated thread to their waiters */
+void so_task_mutex_release_all(so_thread_t *owner)
+{
+	so_task_mutex_t *mutex;
+
+	while (owner->owned_mutexes != NULL) {
+		mutex = owner->owned_mutexes;
+		drop_mutex(mutex);
+		hand_over(mutex);
+	}
+}
+
+/* destroy a task mutex */
+void so_task_mutex_destroy(so_task_mutex_t *mutex)
+{
+	if (mutex == NULL || mutex->waiters == NULL)
+		return;
+
+	DIE(!priority_queue_empty(mutex->waiters), "task mutex in use");
+	priority_queue_free(mutex->waiters);
+	mutex->waiters = NULL;
+}
@@ -0,0 +1,239 @@
+/* Copyright Radu Nichita radunichita99@gmail.com */
+#include "so_sched_internal.h"
+#include "comparators.h"
+#include "utils.h"
+
+/* initialize a task read-write lock */
+int so_task_rwlock_init(so_task_rwlock_t *rwlock)
+{
+	if (rwlock == NULL)
+		return SO_FAILURE;
+
+	rwlock->readers = 0;
+	rwlock->writer = NULL;
+	rwlock->next_written = NULL;
+	rwlock->sched = NULL;
+	rwlock->waiting_readers = so_sched_queue_init();
+	rwlock->waiting_writers = so_sched_queue_init();
+	return SO_SUCCESS;
+}
+
+/* record a read hold of the lock by a task */
+static void take_read(so_task_rwlock_t *rwlock, so_thread_t *reader)
+{
+	reader->read_locks[reader->num_read_locks++] = rwlock;
+	rwlock->readers++;
+}
+
+/** drop a read hold of the lock by a task
+ * @return SO_SUCCESS or SO_FAILURE if the task does not hold the lock
+ */
+static int drop_read(so_task_rwlock_t *rwlock, so_thread_t *reader)
+{
+	unsigned int i;
+
+	for (i = 0; i < reader->num_read_locks; i++) {
+		if (reader->read_locks[i] != rwlock)
+			continue;
+
+		reader->read_locks[i] =
+			reader->read_locks[--reader->num_read_locks];
+		rwlock->readers--;
+		return SO_SUCCESS;
+	}
+	return SO_FAILURE;
+}
+
+/* add the lock in the list of locks held by a writer */
+static void take_write(so_task_rwlock_t *rwlock, so_thread_t *writer)
+{
+	rwlock->writer = writer;
+	rwlock->next_written = writer->written_locks;
+	writer->written_locks = rwlock;
+}
+
+/* remove the lock from the list of locks held by its writer */
+static void drop_write(so_task_rwlock_t *rwlock)
+{
+	so_task_rwlock_t **link;
+
+	link = &rwlock->writer->written_locks;
+	while (*link != rwlock)
+		link = &(*link)->next_written;
+	*link = rwlock->next_written;
+
+	rwlock->writer = NULL;
+	rwlock->next_written = NULL;
+	rwlock->sched = NULL;
+}
+
+/* get the waiting task with the highest priority or NULL */
+static so_thread_t *first_waiter(priority_queue_t *pq)
+{
+	if (priority_queue_empty(pq))
+		return NULL;
+	return *(so_thread_t **) priority_queue_top(pq);
+}
+
+/* checks if the first waiting writer goes before a task */
+static int writer_first(so_task_rwlock_t *rwlock, so_thread_t *so_thread)
+{
+	so_thread_t *writer = first_waiter(rwlock->waiting_writers);
+
+	return writer != NULL &&
+		compare_so_threads(&writer, &so_thread) < 0;
+}
+
+/* let in the waiting readers that go before the best waiting writer */
+static void admit_readers(so_task_rwlock_t *rwlock)
+{
+	so_thread_t *reader;
+
+	reader = first_waiter(rwlock->waiting_readers);
+	while (reader != NULL && !writer_first(rwlock, reader)) {
+		so_sched_wake(so_sched_dequeue(rwlock->waiting_readers));
+		take_read(rwlock, reader);
+		reader = first_waiter(rwlock->waiting_readers);
+	}
+}
+
+/** hand the free lock either to the best waiting writer or to all the
+ * readers that go before it
+ */
+static void grant_lock(so_task_rwlock_t *rwlock)
+{
+	so_thread_t *reader;
+	so_thread_t *writer;
+
+	reader = first_waiter(rwlock->waiting_readers);
+	if (reader == NULL || writer_first(rwlock, reader)) {
+		if (!priority_queue_empty(rwlock->waiting_writers)) {
+			writer = so_sched_dequeue(rwlock->waiting_writers);
+			take_write(rwlock, writer);
+			so_sched_wake(writer);
+		}
+		return;
+	}
+
+	admit_readers(rwlock);
+}
+
+/** a writer cancelled while waiting no longer keeps out the readers that
+ * came after it
+ */
+static void leave_writers(void *object)
+{
+	so_task_rwlock_t *rwlock = object;
+
+	if (rwlock->writer != NULL)
+		return;
+	if (rwlock->readers == 0)
+		grant_lock(rwlock);
+	else
+		admit_readers(rwlock);
+}
+
+/* lock for reading */
+int so_task_rwlock_rdlock(so_task_rwlock_t *rwlock)
+{
+	so_thread_t *running_thread;
+	int status = SO_SUCCESS;
+
+	if (rwlock == NULL || rwlock->waiting_readers == NULL ||
+		so_sched_bind(&rwlock->sched) < 0)
+		return SO_FAILURE;
+
+	running_thread = so_sched_enter();
+
+	/* let a waiting writer with a higher priority go first */
+	if (running_thread->num_read_locks == SO_MAX_READ_LOCKS)
+		status = SO_FAILURE;
+	else if (rwlock->writer == NULL &&
+		!writer_first(rwlock, running_thread))
+		take_read(rwlock, running_thread);
+	else
+		so_sched_park(rwlock->waiting_readers);
+
+	so_sched_leave();
+	return status;
+}
+
+/* lock for writing */
+int so_task_rwlock_wrlock(so_task_rwlock_t *rwlock)
+{
+	so_thread_t *running_thread;
+
+	if (rwlock == NULL || rwlock->waiting_writers == NULL ||
+		so_sched_bind(&rwlock->sched) < 0)
+		return SO_FAILURE;
+
+	running_thread = so_sched_enter();
+
+	if (rwlock->writer == NULL && rwlock->readers == 0)
+		take_write(rwlock, running_thread);
+	else
+		so_sched_park_cleanup(rwlock->waiting_writers, leave_writers,
+				rwlock);
+
+	so_sched_leave();
+	return SO_SUCCESS;
+}
+
+/* unlock a read-write lock held by the running task */
+int so_task_rwlock_unlock(so_task_rwlock_t *rwlock)
+{
+	so_thread_t *running_thread;
+	int status = SO_SUCCESS;
+
+	if (rwlock == NULL || rwlock->waiting_writers == NULL ||
+		so_sched_bind(&rwlock->sched) < 0)
+		return SO_FAILURE;
+
+	running_thread = so_sched_enter();
+
+	if (rwlock->writer == running_thread)
+		drop_write(rwlock);
+	else
+		status = drop_read(rwlock, running_thread);
+
+	if (status == SO_SUCCESS && rwlock->writer == NULL &&
+		rwlock->readers == 0)
+		grant_lock(rwlock);
+
+	so_sched_leave();
+	return status;
+}
+
+/* release the locks held by a terminated or cancelled task */
+void so_task_rwlock_release_all(so_thread_t *owner)
+{
+	so_task_rwlock_t *rwlock;
+
+	while (owner->num_read_locks > 0) {
+		rwlock = owner->read_locks[owner->num_read_locks - 1];
+		drop_read(rwlock, owner);
+		if (rwlock->readers == 0)
+			grant_lock(rwlock);
+	}
+
+	while (owner->written_locks != NULL) {
+		rwlock = owner->written_locks;
+		drop_write(rwlock);
+		grant_lock(rwlock);
+	}
+}
+
+/* destroy a task read-write lock */
+void so_task_rwlock_destroy(so_task_rwlock_t *rwlock)
+{
+	if (rwlock == NULL || rwlock->waiting_readers == NULL)
+		return;
+
+	DIE(!priority_queue_empty(rwlock->waiting_readers) ||
+		!priority_queue_empty(rwlock->waiting_writers),
+		"task rwlock in use");
+	priority_queue_free(rwlock->waiting_readers);
+	priority_queue_free(rwlock->waiting_writers);
+	rwlock->waiting_readers = NULL;
+	rwlock->waiting_writers = NULL;
+}
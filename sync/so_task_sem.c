@@ -0,0 +1,81 @@
+/* Copyright Radu Nichita radunichita99@gmail.com */
+#include "so_sched_internal.h"
+#include "utils.h"
+
+/* initialize a task semaphore */
+int so_task_sem_init(so_task_sem_t *sem, unsigned int value)
+{
+	if (sem == NULL)
+		return SO_FAILURE;
+
+	sem->value = value;
+	sem->sched = NULL;
+	sem->waiters = so_sched_queue_init();
+	return SO_SUCCESS;
+}
+
+static void return_permit(void *object);
+
+/** give a permit to the best waiter if there is one. The permit goes back
+ * to the semaphore if the waiter is cancelled before it runs again.
+ */
+static void give_permit(so_task_sem_t *sem)
+{
+	if (priority_queue_empty(sem->waiters)) {
+		sem->value++;
+		return;
+	}
+
+	so_sched_wake_cleanup(so_sched_dequeue(sem->waiters), return_permit,
+			sem);
+}
+
+/* pass on the permit handed to a thread cancelled before taking it */
+static void return_permit(void *object)
+{
+	give_permit(object);
+}
+
+/* take a permit or wait for one */
+int so_task_sem_wait(so_task_sem_t *sem)
+{
+	if (sem == NULL || sem->waiters == NULL ||
+		so_sched_bind(&sem->sched) < 0)
+		return SO_FAILURE;
+
+	so_sched_enter();
+
+	/* the permit is handed over by post, nothing to check after waking */
+	if (sem->value > 0)
+		sem->value--;
+	else
+		so_sched_park(sem->waiters);
+
+	so_sched_leave();
+	return SO_SUCCESS;
+}
+
+/* release a permit, giving it to the best waiter if there is one */
+int so_task_sem_post(so_task_sem_t *sem)
+{
+	if (sem == NULL || sem->waiters == NULL ||
+		so_sched_bind(&sem->sched) < 0)
+		return SO_FAILURE;
+
+	so_sched_enter();
+	give_permit(sem);
+
+	so_sched_leave();
+	return SO_SUCCESS;
+}
+
+/* destroy a task semaphore */
+void so_task_sem_destroy(so_task_sem_t *sem)
+{
+	if (sem == NULL || sem->waiters == NULL)
+		return;
+
+	DIE(!priority_queue_empty(sem->waiters), "task semaphore in use");
+	priority_queue_free(sem->waiters);
+	sem->waiters = NULL;
+}
@@ -1,3 +1,13 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
 #include "so_thread.h"
 
 /* initialize a mutex */
@@ -125,6 +135,15 @@ SO_BOOL so_semaphore_init(so_sem_t *sem, int sem_value)
 	return rc;
 }
 
+/* initialize a semaphore shared between processes */
+SO_BOOL so_semaphore_init_shared(so_sem_t *sem, int sem_value)
+{
+	int rc;
+
+	rc = sem_init(sem, SHARE_PROCESS, sem_value);
+	return rc == 0 ? TRUE : FALSE;
+}
+
 /* acquire a semaphore */
 SO_BOOL so_semaphore_acquire(so_sem_t *sem)
 {
@@ -156,10 +175,153 @@ SO_BOOL so_semaphore_destroy(so_sem_t *sem)
 SO_BOOL so_create_thread(tid_t *thread,
 					void* (*routine)(void *), void *arg)
 {
+	return so_create_thread_on(thread, routine, arg, -1);
+}
+
+/* create a thread, pinned to a cpu unless it is negative */
+SO_BOOL so_create_thread_on(tid_t *thread,
+			void* (*routine)(void *), void *arg, int cpu)
+{
+	pthread_attr_t attr;
+	cpu_set_t set;
 	int rc;
 
-	rc = pthread_create(thread, NULL, routine, arg);
-	return rc;
+	if (cpu >= CPU_SETSIZE)
+		return FALSE;
+
+	rc = pthread_attr_init(&attr);
+	if (rc != 0)
+		return FALSE;
+
+	/* the thread fails to start if it cannot run on the cpu */
+	if (cpu >= 0) {
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		rc = pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t),
+				&set);
+	}
+	if (rc == 0)
+		rc = pthread_create(thread, &attr, routine, arg);
+	pthread_attr_destroy(&attr);
+	return rc == 0 ? TRUE : FALSE;
+}
+
+/* allocate memory shared with the child processes */
+void *so_shared_alloc(size_t size)
+{
+	void *mem;
+
+	mem = mmap(NULL, size, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	return mem == MAP_FAILED ? NULL : mem;
+}
+
+/* release shared memory */
+void so_shared_free(void *mem, size_t size)
+{
+	munmap(mem, size);
+}
+
+/* create a process running a function */
+SO_BOOL so_create_process(so_process_t *process, void (*routine)(void *),
+				void *arg)
+{
+	pid_t pid;
+
+	/* a program run by exec must not keep the doorbell open */
+	if (pipe2(process->doorbell, O_CLOEXEC) < 0)
+		return FALSE;
+
+	pid = fork();
+	if (pid < 0) {
+		close(process->doorbell[0]);
+		close(process->doorbell[1]);
+		return FALSE;
+	}
+
+	/** the child drops the read end right away and keeps only the write
+	 * end, so the parent sees its exit. The process may be kept in memory
+	 * shared with the child, so only the parent writes its id.
+	 */
+	if (pid == 0) {
+		close(process->doorbell[0]);
+		routine(arg);
+		_exit(EXIT_SUCCESS);
+	}
+	process->pid = pid;
+	close(process->doorbell[1]);
+	return TRUE;
+}
+
+/* notify the parent of the calling process */
+SO_BOOL so_process_notify(so_process_t *process)
+{
+	char bell = 0;
+	ssize_t rc;
+
+	do {
+		rc = write(process->doorbell[1], &bell, 1);
+	} while (rc < 0 && errno == EINTR);
+	return rc == 1 ? TRUE : FALSE;
+}
+
+/* wait for a notification or for the exit of a process */
+SO_BOOL so_process_wait(so_process_t *process)
+{
+	char bell;
+	ssize_t rc;
+
+	do {
+		rc = read(process->doorbell[0], &bell, 1);
+	} while (rc < 0 && errno == EINTR);
+	return rc == 1 ? TRUE : FALSE;
+}
+
+/* kill and reap a process, which fails if it cannot be reaped */
+SO_BOOL so_process_end(so_process_t *process)
+{
+	int status = 0;
+	pid_t rc;
+
+	kill(process->pid, SIGKILL);
+	do {
+		rc = waitpid(process->pid, &status, 0);
+	} while (rc < 0 && errno == EINTR);
+	close(process->doorbell[0]);
+	if (rc < 0)
+		return FALSE;
+	return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS ?
+			TRUE : FALSE;
+}
+
+/* pin a thread to a cpu */
+SO_BOOL so_set_thread_cpu(tid_t thread, int cpu)
+{
+	cpu_set_t set;
+	int rc;
+
+	if (cpu < 0 || cpu >= CPU_SETSIZE)
+		return FALSE;
+
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	rc = pthread_setaffinity_np(thread, sizeof(cpu_set_t), &set);
+	return rc == 0 ? TRUE : FALSE;
+}
+
+/* check if a cpu index fits in a cpu set */
+SO_BOOL so_cpu_valid(int cpu)
+{
+	return cpu >= 0 && cpu < CPU_SETSIZE ? TRUE : FALSE;
+}
+
+/* get the time of a monotonic clock in nanoseconds */
+unsigned long long so_time_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (unsigned long long)now.tv_sec * 1000000000ULL + now.tv_nsec;
 }
 
 /* join a thread */
@@ -170,3 +332,15 @@ SO_BOOL so_join_thread(tid_t thread)
 	rc = pthread_join(thread, NULL);
 	return rc;
 }
+
+/* get the id of the calling thread */
+tid_t so_thread_self(void)
+{
+	return pthread_self();
+}
+
+/* compare two thread ids */
+SO_BOOL so_equal_threads(tid_t first, tid_t second)
+{
+	return pthread_equal(first, second) ? TRUE : FALSE;
+}
@@ -163,22 +163,42 @@ SO_BOOL so_semaphore_destroy(so_sem_t *sem)
 /* create a thread and start it detached */
 SO_BOOL so_create_thread(tid_t *thread,
 					void* (*routine)(void *), void *arg)
+{
+	return so_create_thread_on(thread, routine, arg, -1);
+}
+
+/** create a thread pinned to a cpu unless it is negative. The thread is
+ * created suspended and started only once it is pinned.
+ */
+SO_BOOL so_create_thread_on(tid_t *thread,
+			void* (*routine)(void *), void *arg, int cpu)
 {
 	HANDLE h;
 	BOOL rc;
 
+	if (cpu >= (int)(sizeof(DWORD_PTR) * 8))
+		return FALSE;
+
 	h = CreateThread(
 		NULL,
 		0,
 		(LPTHREAD_START_ROUTINE) routine,
 		arg,
-		0,
+		CREATE_SUSPENDED,
 		thread
 	);
 
 	/* if couldn't create thread, return */
-	if (h == INVALID_HANDLE_VALUE)
+	if (h == NULL)
+		return FALSE;
+
+	/* a thread which has never run can be terminated safely */
+	if (cpu >= 0 && SetThreadAffinityMask(h, (DWORD_PTR)1 << cpu) == 0) {
+		TerminateThread(h, 0);
+		CloseHandle(h);
 		return FALSE;
+	}
+	ResumeThread(h);
 
 	/* make thread detachable */
 	rc = CloseHandle(h);
@@ -193,3 +213,89 @@ SO_BOOL so_join_thread(tid_t thread)
 {
 	return TRUE;
 }
+
+/* get the id of the calling thread */
+tid_t so_thread_self(void)
+{
+	return GetCurrentThreadId();
+}
+
+/* compare two thread ids */
+SO_BOOL so_equal_threads(tid_t first, tid_t second)
+{
+	return first == second;
+}
+
+/* pin a thread to a cpu */
+SO_BOOL so_set_thread_cpu(tid_t thread, int cpu)
+{
+	HANDLE handle;
+	DWORD_PTR rc;
+
+	if (cpu < 0 || cpu >= (int)(sizeof(DWORD_PTR) * 8))
+		return FALSE;
+
+	handle = OpenThread(THREAD_SET_INFORMATION |
+			THREAD_QUERY_INFORMATION, FALSE, thread);
+	if (handle == NULL)
+		return FALSE;
+
+	rc = SetThreadAffinityMask(handle, (DWORD_PTR)1 << cpu);
+	CloseHandle(handle);
+	return rc != 0 ? TRUE : FALSE;
+}
+
+/* check if a cpu index fits in an affinity mask */
+SO_BOOL so_cpu_valid(int cpu)
+{
+	return cpu >= 0 && cpu < (int)(sizeof(DWORD_PTR) * 8) ? TRUE : FALSE;
+}
+
+/* get the time of a monotonic clock in nanoseconds */
+unsigned long long so_time_ns(void)
+{
+	LARGE_INTEGER now, frequency;
+
+	QueryPerformanceCounter(&now);
+	QueryPerformanceFrequency(&frequency);
+	return (unsigned long long)(now.QuadPart /
+		frequency.QuadPart * 1000000000ULL +
+		now.QuadPart % frequency.QuadPart * 1000000000ULL /
+		frequency.QuadPart);
+}
+
+/* processes sharing the scheduler are not supported on Windows */
+SO_BOOL so_semaphore_init_shared(so_sem_t *sem, int sem_value)
+{
+	return FALSE;
+}
+
+void *so_shared_alloc(size_t size)
+{
+	return NULL;
+}
+
+void so_shared_free(void *mem, size_t size)
+{
+}
+
+SO_BOOL so_create_process(so_process_t *process, void (*routine)(void *),
+				void *arg)
+{
+	return FALSE;
+}
+
+SO_BOOL so_process_notify(so_process_t *process)
+{
+	return FALSE;
+}
+
+SO_BOOL so_process_wait(so_process_t *process)
+{
+	return FALSE;
+}
+
+SO_BOOL so_process_end(so_process_t *process)
+{
+	return FALSE;
+}